@@ -0,0 +1,176 @@
+#include "barnes_hut_tree.hpp"
+
+// std
+#include <algorithm>
+
+namespace sve {
+
+// spreads the lower 16 bits of v out so there is a zero bit between each of them
+static uint32_t spreadBits(uint32_t v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+void BarnesHutTree::build(const float *positionX, const float *positionY, const float *masses, size_t count) {
+    nodes.clear();
+    keys.resize(count);
+    codes.resize(count);
+    order.resize(count);
+    sortedPositions.resize(count);
+    sortedMasses.resize(count);
+    if (count == 0) return;
+
+    // square bounding box around all bodies
+    glm::vec2 lo{positionX[0], positionY[0]};
+    glm::vec2 hi = lo;
+    for (size_t i = 1; i < count; i++) {
+        lo = glm::min(lo, glm::vec2{positionX[i], positionY[i]});
+        hi = glm::max(hi, glm::vec2{positionX[i], positionY[i]});
+    }
+    float extent = glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), 1e-6f);
+
+    // quantize to a 65536 x 65536 grid so a cell at depth d spans exactly extent / 2^d
+    const float scale = 65536.f / extent;
+    for (size_t i = 0; i < count; i++) {
+        glm::vec2 q = (glm::vec2{positionX[i], positionY[i]} - lo) * scale;
+        uint32_t qx = std::min(static_cast<uint32_t>(q.x), 65535u);
+        uint32_t qy = std::min(static_cast<uint32_t>(q.y), 65535u);
+        uint64_t code = spreadBits(qx) | (spreadBits(qy) << 1);
+        keys[i] = (code << 32) | static_cast<uint64_t>(i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t i = 0; i < count; i++) {
+        codes[i] = static_cast<uint32_t>(keys[i] >> 32);
+        order[i] = static_cast<uint32_t>(keys[i] & 0xffffffff);
+        sortedPositions[i] = {positionX[order[i]], positionY[order[i]]};
+        sortedMasses[i] = masses[order[i]];
+    }
+
+    nodes.emplace_back();
+    nodes[0].corner = lo;
+    nodes[0].size = extent;
+    buildNode(0, 0, static_cast<uint32_t>(count), 0);
+}
+
+void BarnesHutTree::refit(const float *positionX, const float *positionY) {
+    for (size_t i = 0; i < order.size(); i++) {
+        sortedPositions[i] = {positionX[order[i]], positionY[order[i]]};
+    }
+
+    // children always come after their parent in nodes, so walking backwards visits them first
+    upperCorners.resize(nodes.size());
+    for (size_t n = nodes.size(); n-- > 0;) {
+        Node &node = nodes[n];
+        glm::vec2 lo{};
+        glm::vec2 hi{};
+        float mass = 0.f;
+        glm::vec2 weighted{};
+        glm::vec2 sum{};
+
+        if (node.childCount == 0) {
+            lo = hi = sortedPositions[node.begin];
+            for (uint32_t i = node.begin; i < node.end; i++) {
+                lo = glm::min(lo, sortedPositions[i]);
+                hi = glm::max(hi, sortedPositions[i]);
+                mass += sortedMasses[i];
+                weighted += sortedMasses[i] * sortedPositions[i];
+                sum += sortedPositions[i];
+            }
+            node.centerOfMass = mass > 0.f ? weighted / mass : sum / static_cast<float>(node.end - node.begin);
+        } else {
+            lo = nodes[node.firstChild].corner;
+            hi = upperCorners[node.firstChild];
+            for (uint32_t c = 0; c < node.childCount; c++) {
+                const Node &child = nodes[node.firstChild + c];
+                lo = glm::min(lo, child.corner);
+                hi = glm::max(hi, upperCorners[node.firstChild + c]);
+                mass += child.mass;
+                weighted += child.mass * child.centerOfMass;
+                sum += child.centerOfMass;
+            }
+            node.centerOfMass = mass > 0.f ? weighted / mass : sum / static_cast<float>(node.childCount);
+        }
+
+        // cells stay square so the opening test keeps working with a single size, the tiny margin
+        // keeps bodies on the upper edge inside of their own cell
+        node.mass = mass;
+        node.corner = lo;
+        node.size = glm::max(hi.x - lo.x, hi.y - lo.y) * 1.0001f + 1e-12f;
+        upperCorners[n] = lo + glm::vec2{node.size};
+    }
+}
+
+void BarnesHutTree::buildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, int depth) {
+    nodes[nodeIndex].begin = begin;
+    nodes[nodeIndex].end = end;
+
+    if (end - begin <= LEAF_CAPACITY || depth == MAX_DEPTH) {
+        float mass = 0.f;
+        glm::vec2 weighted{};
+        glm::vec2 sum{};
+        for (uint32_t i = begin; i < end; i++) {
+            mass += sortedMasses[i];
+            weighted += sortedMasses[i] * sortedPositions[i];
+            sum += sortedPositions[i];
+        }
+        nodes[nodeIndex].mass = mass;
+        nodes[nodeIndex].centerOfMass = mass > 0.f ? weighted / mass : sum / static_cast<float>(end - begin);
+        return;
+    }
+
+    // every body in this node shares the code bits above shift, so the two bits at shift pick the
+    // quadrant and are sorted within the range (bit 0 is x, bit 1 is y)
+    const uint32_t shift = 2 * (MAX_DEPTH - 1 - depth);
+    uint32_t splits[5] = {begin, begin, begin, begin, end};
+    for (uint32_t q = 1; q < 4; q++) {
+        splits[q] = static_cast<uint32_t>(
+            std::partition_point(
+                codes.begin() + splits[q - 1],
+                codes.begin() + end,
+                [&](uint32_t code) { return ((code >> shift) & 3) < q; }) -
+            codes.begin());
+    }
+
+    // allocate all children up front so siblings stay contiguous, nodes may reallocate from here on
+    uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+    uint32_t childCount = 0;
+    const float childSize = nodes[nodeIndex].size * 0.5f;
+    for (uint32_t q = 0; q < 4; q++) {
+        if (splits[q] == splits[q + 1]) continue;
+        Node child{};
+        child.corner = nodes[nodeIndex].corner +
+                       glm::vec2{(q & 1) ? childSize : 0.f, (q & 2) ? childSize : 0.f};
+        child.size = childSize;
+        child.begin = splits[q];
+        child.end = splits[q + 1];
+        nodes.push_back(child);
+        childCount++;
+    }
+
+    for (uint32_t c = 0; c < childCount; c++) {
+        buildNode(firstChild + c, nodes[firstChild + c].begin, nodes[firstChild + c].end, depth + 1);
+    }
+
+    float mass = 0.f;
+    glm::vec2 weighted{};
+    glm::vec2 sum{};
+    for (uint32_t c = 0; c < childCount; c++) {
+        const Node &child = nodes[firstChild + c];
+        mass += child.mass;
+        weighted += child.mass * child.centerOfMass;
+        sum += child.centerOfMass;
+    }
+
+    Node &node = nodes[nodeIndex];
+    node.firstChild = firstChild;
+    node.childCount = childCount;
+    node.mass = mass;
+    node.centerOfMass = mass > 0.f ? weighted / mass : sum / static_cast<float>(childCount);
+}
+
+}  // namespace sve
@@ -0,0 +1,95 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sve {
+
+// Quadtree over a set of point masses used to approximate far away groups of bodies as a single
+// mass at their center of mass. Bodies are sorted along a morton (z-order) curve so every node
+// owns a contiguous range of them, which keeps both the build and the force walk cache friendly.
+class BarnesHutTree {
+   public:
+    static constexpr int MAX_DEPTH = 16;  // morton codes use 16 bits per axis
+    static constexpr uint32_t LEAF_CAPACITY = 8;
+
+    struct Node {
+        glm::vec2 corner{};        // minimum corner of the square cell
+        float size{0.f};           // side length of the cell
+        glm::vec2 centerOfMass{};
+        float mass{0.f};
+        uint32_t firstChild{0};    // children are stored contiguously in nodes
+        uint32_t childCount{0};    // 0 for leaves
+        uint32_t begin{0}, end{0};  // range of bodies in the sorted arrays
+    };
+
+    // rebuilds the tree from scratch, called once per simulation step
+    void build(const float *positionX, const float *positionY, const float *masses, size_t count);
+
+    // Keeps the topology of the last build but moves the bodies to new positions, recomputing every
+    // cell's bounds and center of mass bottom up. Much cheaper than build() when bodies only moved a
+    // little, cells get looser the further they drift from where they were built.
+    void refit(const float *positionX, const float *positionY);
+
+    size_t bodyCount() const { return order.size(); }
+    // index into the arrays passed to build() of the body at the given morton order position
+    uint32_t sortedIndex(size_t i) const { return order[i]; }
+    const std::vector<Node> &getNodes() const { return nodes; }
+
+    // Calls kernel(sourcePosition, sourceMass) for every body or cell that acts on a body at
+    // position. A cell is accepted as a single mass when size / distance < openingAngle and
+    // position is not inside of it, otherwise its children are visited. Leaves always hand
+    // out their individual bodies, including the body at position itself, so kernel has to
+    // handle a zero offset.
+    template <typename Kernel>
+    void forEachInteraction(glm::vec2 position, float openingAngle, Kernel &&kernel) const {
+        if (nodes.empty()) return;
+
+        const float theta2 = openingAngle * openingAngle;
+        uint32_t stack[4 * (MAX_DEPTH + 1)];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            if (node.childCount == 0) {
+                for (uint32_t i = node.begin; i < node.end; i++) {
+                    kernel(sortedPositions[i], sortedMasses[i]);
+                }
+                continue;
+            }
+
+            glm::vec2 offset = node.centerOfMass - position;
+            bool inside = position.x >= node.corner.x && position.x < node.corner.x + node.size &&
+                          position.y >= node.corner.y && position.y < node.corner.y + node.size;
+            if (!inside && node.size * node.size < theta2 * glm::dot(offset, offset)) {
+                kernel(node.centerOfMass, node.mass);
+                continue;
+            }
+
+            for (uint32_t c = 0; c < node.childCount; c++) {
+                stack[top++] = node.firstChild + c;
+            }
+        }
+    }
+
+   private:
+    void buildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, int depth);
+
+    std::vector<Node> nodes;
+    std::vector<uint64_t> keys;  // morton code in the high bits, body index in the low bits
+    std::vector<uint32_t> codes;
+    std::vector<uint32_t> order;
+    std::vector<glm::vec2> sortedPositions;
+    std::vector<float> sortedMasses;
+    std::vector<glm::vec2> upperCorners;  // refit scratch
+};
+
+}  // namespace sve
@@ -0,0 +1,361 @@
+// Runs a fixed set of headless scenarios, the same physics and field loop as HeadlessApp, and compares
+// their throughput and peak memory against the committed bench/perf_baseline.txt. make perf runs it,
+// it is not part of make bench.
+//
+// Every run of a case is a forked child process, so its peak rss is its own and not whatever an
+// earlier case left behind. Throughput is the best of a few runs, the least noisy statistic when
+// the only thing that can make a run faster is the code.
+//
+// Absolute throughput only means something on the machine it was measured on, so the baseline file
+// has a section per machine, keyed by simd level, cpu model and thread count. A run only compares
+// against the section of its own machine. Exits with
+//   0  every case within the tolerance
+//   1  a case got slower or bigger by more than the tolerance, or the run failed
+//   2  the baseline has no section for this machine, record one with --record and commit it
+//
+// usage: perf_regression [--baseline <path>] [--record] [--threads <n>] [--tolerance <fraction>]
+//   --baseline   bench/perf_baseline.txt by default
+//   --record     measures every case and replaces this machine's section instead of comparing
+//   --threads    worker threads, 1 by default
+//   --tolerance  allowed regression, 0.1 (10%) by default
+
+#include "gravity_kernels.hpp"
+#include "gravity_physics_system.hpp"
+#include "sve_scenario.hpp"
+#include "vec2_field_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// posix
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace sve;
+
+struct PerfCase {
+    const char *name;
+    const char *scenarioPath;
+    unsigned int steps;
+};
+
+// Changing a scenario or step count changes what is measured, re-record the baseline with it.
+// Counts are picked for roughly a second per run on one core
+static const PerfCase PERF_CASES[] = {
+    {"two_body", "scenarios/two_body.scn", 30000},
+    {"direct_simd_4k", "scenarios/perf/direct_simd_4k.scn", 200},
+    {"barnes_hut_64k", "scenarios/perf/barnes_hut_64k.scn", 4},
+    {"particle_mesh_256k", "scenarios/perf/particle_mesh_256k.scn", 10},
+    {"block_timestep_4k", "scenarios/perf/block_timestep_4k.scn", 2},
+    {"field_grid_256", "scenarios/perf/field_grid_256.scn", 200},
+};
+
+static constexpr int RUNS_PER_CASE = 3;
+static constexpr int EXIT_NO_BASELINE = 2;
+// the rss of a small case moves by a few hundred KiB with whatever the parent had mapped at the
+// fork, growth below this much is never a regression
+static constexpr long RSS_SLACK_KIB = 1024;
+
+struct PerfResult {
+    std::string name;
+    double stepsPerSecond{0.0};
+    long peakRssKib{0};
+};
+
+// what a baseline's numbers depend on besides the code
+struct MachineFingerprint {
+    std::string simd;
+    std::string cpu;
+    unsigned int threads{1};
+
+    bool operator==(const MachineFingerprint &other) const {
+        return simd == other.simd && cpu == other.cpu && threads == other.threads;
+    }
+};
+
+struct Baseline {
+    MachineFingerprint machine;
+    std::vector<PerfResult> results;
+};
+
+// the model name from /proc/cpuinfo, spaces are kept
+static std::string detectCpuModel() {
+    std::ifstream cpuinfo{"/proc/cpuinfo"};
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") != 0) continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) break;
+        size_t begin = line.find_first_not_of(" \t", colon + 1);
+        return begin == std::string::npos ? "unknown" : line.substr(begin);
+    }
+    return "unknown";
+}
+
+static MachineFingerprint currentMachine(unsigned int threads) {
+    MachineFingerprint machine{};
+    machine.simd = simdLevelName(detectSimdLevel());
+    machine.cpu = detectCpuModel();
+    machine.threads = threads;
+    return machine;
+}
+
+// runs in the child, returns seconds spent stepping
+static double runCase(const PerfCase &perfCase, unsigned int threads) {
+    Scenario scenario = Scenario::load(perfCase.scenarioPath);
+    scenario.threadCount = threads;
+    GravityPhysicsSystem gravitySystem{scenario.strength, scenario.threadCount};
+    scenario.configure(gravitySystem);
+    Vec2FieldSystem vecFieldSystem{};
+
+    SveBodyStore bodies{};
+    scenario.generateBodies(gravitySystem.getThreadPool(), bodies);
+    Vec2FieldSamples fieldSamples{};
+    scenario.createFieldSamples(fieldSamples);
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int step = 0; step < perfCase.steps; step++) {
+        gravitySystem.update(bodies, scenario.tickDelta, scenario.substeps);
+        vecFieldSystem.update(gravitySystem, bodies, fieldSamples);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// forks, runs the case in the child and reads back its time and peak rss
+static PerfResult runIsolated(const PerfCase &perfCase, unsigned int threads) {
+    int fds[2];
+    if (pipe(fds) != 0) throw std::runtime_error("failed to create pipe");
+
+    // nothing in this process has started a thread, so the child can do anything after the fork
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("failed to fork");
+    if (pid == 0) {
+        close(fds[0]);
+        double seconds = -1.0;
+        try {
+            seconds = runCase(perfCase, threads);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s: %s\n", perfCase.name, e.what());
+        }
+        bool written = write(fds[1], &seconds, sizeof(seconds)) == sizeof(seconds);
+        _exit(written && seconds >= 0.0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    double seconds = -1.0;
+    bool received = read(fds[0], &seconds, sizeof(seconds)) == sizeof(seconds);
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        throw std::runtime_error(std::string{"case "} + perfCase.name + " failed");
+    }
+
+    PerfResult result{};
+    result.name = perfCase.name;
+    result.stepsPerSecond = seconds > 0.0 ? perfCase.steps / seconds : 0.0;
+    result.peakRssKib = usage.ru_maxrss;  // kilobytes on linux
+    return result;
+}
+
+static PerfResult measure(const PerfCase &perfCase, unsigned int threads) {
+    PerfResult best{};
+    for (int run = 0; run < RUNS_PER_CASE; run++) {
+        PerfResult result = runIsolated(perfCase, threads);
+        best.name = result.name;
+        best.stepsPerSecond = std::max(best.stepsPerSecond, result.stepsPerSecond);
+        best.peakRssKib = std::max(best.peakRssKib, result.peakRssKib);
+    }
+    return best;
+}
+
+// Baseline files have one setting per line, # starts a comment. Every machine line starts the section
+// of another machine:
+//
+//   machine
+//   simd avx2
+//   cpu Intel(R) Xeon(R) ...          the rest of the line
+//   threads 1
+//   case two_body 12345.6 4321       name, steps per second, peak rss in KiB
+static std::vector<Baseline> readBaselines(std::ifstream &file, const std::string &path) {
+    std::vector<Baseline> baselines{};
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words{line};
+        std::string key;
+        if (!(words >> key)) continue;
+
+        if (key == "machine") {
+            baselines.emplace_back();
+            continue;
+        }
+        if (baselines.empty()) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": setting before the first machine");
+        }
+        Baseline &baseline = baselines.back();
+        bool ok;
+        if (key == "simd") {
+            ok = static_cast<bool>(words >> baseline.machine.simd);
+        } else if (key == "cpu") {
+            std::getline(words >> std::ws, baseline.machine.cpu);
+            ok = !baseline.machine.cpu.empty();
+        } else if (key == "threads") {
+            ok = static_cast<bool>(words >> baseline.machine.threads);
+        } else if (key == "case") {
+            PerfResult result{};
+            ok = static_cast<bool>(words >> result.name >> result.stepsPerSecond >> result.peakRssKib);
+            baseline.results.push_back(result);
+        } else {
+            ok = false;
+        }
+        if (!ok) throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": malformed line");
+    }
+    return baselines;
+}
+
+static void writeBaselines(const std::string &path, const std::vector<Baseline> &baselines) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) throw std::runtime_error("failed to open " + path);
+    std::fprintf(file, "# perf_regression baseline, a machine's section is rewritten by perf_regression --record\n");
+    std::fprintf(file, "# case <name> <steps per second> <peak rss KiB>\n");
+    for (const Baseline &baseline : baselines) {
+        std::fprintf(file, "\nmachine\n");
+        std::fprintf(file, "simd %s\n", baseline.machine.simd.c_str());
+        std::fprintf(file, "cpu %s\n", baseline.machine.cpu.c_str());
+        std::fprintf(file, "threads %u\n", baseline.machine.threads);
+        for (const PerfResult &r : baseline.results) {
+            std::fprintf(file, "case %s %.3f %ld\n", r.name.c_str(), r.stepsPerSecond, r.peakRssKib);
+        }
+    }
+    std::fclose(file);
+}
+
+int main(int argc, char **argv) {
+    std::string baselinePath = "bench/perf_baseline.txt";
+    bool record = false;
+    unsigned int threads = 1;
+    double tolerance = 0.1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            std::fprintf(
+                stderr,
+                "usage: %s [--baseline <path>] [--record] [--threads <n>] [--tolerance <fraction>]\n",
+                argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::vector<Baseline> baselines{};
+        std::ifstream baselineFile{baselinePath};
+        if (baselineFile) baselines = readBaselines(baselineFile, baselinePath);
+        baselineFile.close();
+
+        const MachineFingerprint machine = currentMachine(threads);
+        auto section = std::find_if(
+            baselines.begin(), baselines.end(), [&](const Baseline &b) { return b.machine == machine; });
+
+        if (record) {
+            std::printf("recording %s, %s, %u threads into %s\n", machine.cpu.c_str(), machine.simd.c_str(),
+                        threads, baselinePath.c_str());
+            Baseline recorded{};
+            recorded.machine = machine;
+            for (const PerfCase &perfCase : PERF_CASES) {
+                recorded.results.push_back(measure(perfCase, threads));
+                std::printf(
+                    "%-22s %12.2f steps/s %10ld KiB\n",
+                    perfCase.name,
+                    recorded.results.back().stepsPerSecond,
+                    recorded.results.back().peakRssKib);
+            }
+            if (section != baselines.end()) {
+                *section = recorded;
+            } else {
+                baselines.push_back(recorded);
+            }
+            writeBaselines(baselinePath, baselines);
+            return EXIT_SUCCESS;
+        }
+
+        // without numbers from this machine there is nothing to compare against, which must not look
+        // like a pass
+        if (section == baselines.end()) {
+            std::printf(
+                "%s has no baseline for %s, %s, %u threads. Record one with --record and commit it\n",
+                baselinePath.c_str(),
+                machine.cpu.c_str(),
+                machine.simd.c_str(),
+                machine.threads);
+            return EXIT_NO_BASELINE;
+        }
+        const Baseline &baseline = *section;
+
+        std::printf("%-22s %14s %14s %8s %12s %12s %8s\n", "case", "base steps/s", "steps/s", "change",
+                    "base KiB", "KiB", "change");
+        int regressions = 0;
+        for (const PerfCase &perfCase : PERF_CASES) {
+            auto base = std::find_if(baseline.results.begin(), baseline.results.end(), [&](const PerfResult &r) {
+                return r.name == perfCase.name;
+            });
+            if (base == baseline.results.end()) {
+                std::printf("%-22s not in the baseline, re-record it\n", perfCase.name);
+                regressions++;
+                continue;
+            }
+
+            PerfResult current = measure(perfCase, threads);
+            // both are signed so that worse is positive
+            double slowdown = 1.0 - current.stepsPerSecond / base->stepsPerSecond;
+            double growth = static_cast<double>(current.peakRssKib) / base->peakRssKib - 1.0;
+            bool regressed = slowdown > tolerance ||
+                             (growth > tolerance && current.peakRssKib - base->peakRssKib > RSS_SLACK_KIB);
+            regressions += regressed;
+            std::printf(
+                "%-22s %14.2f %14.2f %+7.1f%% %12ld %12ld %+7.1f%%%s\n",
+                perfCase.name,
+                base->stepsPerSecond,
+                current.stepsPerSecond,
+                -slowdown * 100.0,
+                base->peakRssKib,
+                current.peakRssKib,
+                growth * 100.0,
+                regressed ? "  REGRESSION" : "");
+        }
+
+        if (regressions > 0) {
+            std::printf("%d of %zu cases regressed by more than %.0f%%\n", regressions, std::size(PERF_CASES),
+                        tolerance * 100.0);
+            return EXIT_FAILURE;
+        }
+        std::printf("no regressions beyond %.0f%%\n", tolerance * 100.0);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
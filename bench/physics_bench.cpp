@@ -0,0 +1,239 @@
+// Times the physics and field kernels across body counts and field grid sizes. Every case is warmed
+// up, then run for a number of trials that each repeat the operation enough times to be well above
+// timer resolution. Prints a table and writes the per operation median and p99 in nanoseconds as json.
+//
+// usage: physics_bench [--json <path>] [--quick] [--threads <n>]
+//   --json     where the results go, bench/physics_bench.json by default
+//   --quick    stops at 64k bodies and 256^2 field samples for a fast check
+//   --threads  size of the worker pool, 0 (the default) uses every hardware thread
+
+#include "gravity_physics_system.hpp"
+#include "sve_scenario.hpp"
+#include "vec2_field_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sve;
+
+// a trial repeats the operation until it has run at least this long
+static constexpr double MIN_TRIAL_SECONDS = 2e-3;
+// trials stop once a case has used this much time, but never before MIN_TRIALS
+static constexpr double CASE_BUDGET_SECONDS = 2.0;
+static constexpr int MIN_TRIALS = 5;
+static constexpr int MAX_TRIALS = 101;
+
+struct BenchResult {
+    std::string name;
+    size_t bodies;
+    size_t fieldSamples;
+    size_t iterations;  // operations per trial
+    size_t trials;
+    double medianNs;  // per operation
+    double p99Ns;
+};
+
+// nearest rank percentile of sorted samples
+static double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// opsPerCall is how many operations one call of op does, results are per operation
+static BenchResult measure(
+    const std::string &name, size_t bodies, size_t fieldSamples, const std::function<void()> &op, size_t opsPerCall = 1) {
+    // warmup, doubling the repetitions until a trial is long enough to time
+    size_t iterations = 1;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            op();
+        }
+        if (secondsSince(start) >= MIN_TRIAL_SECONDS) break;
+        iterations *= 2;
+    }
+
+    std::vector<double> samples;
+    auto caseStart = std::chrono::steady_clock::now();
+    while (samples.size() < static_cast<size_t>(MIN_TRIALS) ||
+           (samples.size() < static_cast<size_t>(MAX_TRIALS) && secondsSince(caseStart) < CASE_BUDGET_SECONDS)) {
+        auto trialStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            op();
+        }
+        samples.push_back(secondsSince(trialStart) * 1e9 / (iterations * opsPerCall));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result{name, bodies, fieldSamples, iterations, samples.size(), percentile(samples, 0.5), percentile(samples, 0.99)};
+    std::printf(
+        "%-28s %9zu %9zu %14.1f %14.1f %6zu\n",
+        name.c_str(),
+        bodies,
+        fieldSamples,
+        result.medianNs,
+        result.p99Ns,
+        result.trials);
+    std::fflush(stdout);
+    return result;
+}
+
+// plummer sphere, the same clustered distribution for every case so the tree and mesh see a
+// realistic load
+static SveBodyStore createBodies(SveThreadPool &pool, size_t count) {
+    Scenario scenario{};
+    BodySetDescription sphere{};
+    sphere.kind = BodySetKind::Plummer;
+    sphere.count = count;
+    sphere.scale = 0.2f;
+    scenario.bodySets.push_back(sphere);
+    SveBodyStore bodies{};
+    scenario.generateBodies(pool, bodies);
+    return bodies;
+}
+
+static const char *solverName(ForceSolver solver) {
+    switch (solver) {
+        case ForceSolver::DirectSum:
+            return "direct";
+        case ForceSolver::DirectSumTiled:
+            return "direct_tiled";
+        case ForceSolver::DirectSumSimd:
+            return "direct_simd";
+        case ForceSolver::BarnesHut:
+            return "barnes_hut";
+        default:
+            return "particle_mesh";
+    }
+}
+
+static void writeJson(const std::string &path, unsigned int threads, const std::vector<BenchResult> &results) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "failed to open %s\n", path.c_str());
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"threads\": %u,\n", threads);
+    std::fprintf(file, "  \"simd\": \"%s\",\n", simdLevelName(detectSimdLevel()));
+    std::fprintf(file, "  \"l1_data_cache_bytes\": %zu,\n", detectL1DataCacheSize());
+    std::fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        std::fprintf(
+            file,
+            "    {\"name\": \"%s\", \"bodies\": %zu, \"field_samples\": %zu, \"iterations\": %zu, "
+            "\"trials\": %zu, \"median_ns\": %.1f, \"p99_ns\": %.1f}%s\n",
+            r.name.c_str(),
+            r.bodies,
+            r.fieldSamples,
+            r.iterations,
+            r.trials,
+            r.medianNs,
+            r.p99Ns,
+            i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+}
+
+int main(int argc, char **argv) {
+    std::string jsonPath = "bench/physics_bench.json";
+    bool quick = false;
+    unsigned int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--json <path>] [--quick] [--threads <n>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const size_t maxBodies = quick ? 64 * 1024 : 1024 * 1024;
+    const size_t maxGrid = quick ? 256 : 1024;
+    // the exact sums are quadratic, past this a single step takes seconds
+    const size_t maxDirectBodies = 16 * 1024;
+    // a small dt keeps the bodies close to where they started over all the trials
+    const float dt = 1e-5f;
+
+    std::vector<size_t> bodyCounts{};
+    for (size_t n = 2; n <= maxBodies; n *= 8) {
+        bodyCounts.push_back(n);
+    }
+    if (bodyCounts.back() != maxBodies) bodyCounts.push_back(maxBodies);
+
+    std::printf("%u threads, simd %s\n", threads, simdLevelName(detectSimdLevel()));
+    std::printf("%-28s %9s %9s %14s %14s %6s\n", "case", "bodies", "samples", "median ns", "p99 ns", "trials");
+
+    std::vector<BenchResult> results{};
+    GravityPhysicsSystem system{0.81f, threads};
+    system.integrator = Integrator::SemiImplicitEuler;  // one force evaluation per update
+
+    for (size_t n : bodyCounts) {
+        SveBodyStore bodies = createBodies(system.getThreadPool(), n);
+
+        for (ForceSolver solver : {ForceSolver::DirectSum, ForceSolver::DirectSumTiled, ForceSolver::DirectSumSimd,
+                                   ForceSolver::BarnesHut, ForceSolver::ParticleMesh}) {
+            bool direct = solver != ForceSolver::BarnesHut && solver != ForceSolver::ParticleMesh;
+            if (direct && n > maxDirectBodies) continue;
+
+            system.solver = solver;
+            results.push_back(measure(std::string{"update/"} + solverName(solver), n, 0, [&] {
+                system.update(bodies, dt, 1);
+            }));
+        }
+
+        // one body against every other, reported per call
+        glm::vec2 sink{0.f};
+        results.push_back(measure(
+            "computeForce",
+            n,
+            0,
+            [&] {
+                const glm::vec2 target = bodies.position(0);
+                for (size_t i = 0; i < bodies.size(); i++) {
+                    sink += system.computeForce(bodies.position(i), bodies.mass[i], target, bodies.mass[0]);
+                }
+            },
+            n));
+        if (sink.x == 12345.f) std::printf(" ");  // keeps the loop from being optimized out
+    }
+
+    // the field cost is samples x bodies, bodies stay at the count the window draws comfortably
+    const size_t fieldBodies = 1024;
+    SveBodyStore fieldSources = createBodies(system.getThreadPool(), fieldBodies);
+    Vec2FieldSystem fieldSystem{};
+    for (size_t grid = 40; grid <= maxGrid; grid = grid == 40 ? 64 : grid * 2) {
+        Scenario scenario{};
+        scenario.fieldGrid = static_cast<unsigned int>(grid);
+        Vec2FieldSamples field{};
+        scenario.createFieldSamples(field);
+        results.push_back(measure("Vec2FieldSystem::update", fieldBodies, field.size(), [&] {
+            fieldSystem.update(system, fieldSources, field);
+        }));
+    }
+
+    writeJson(jsonPath, threads, results);
+    std::printf("results written to %s\n", jsonPath.c_str());
+    return 0;
+}
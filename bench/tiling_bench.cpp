@@ -0,0 +1,63 @@
+// Compares the plain pair loop against the cache blocked one across body counts to find where
+// tiling starts to pay off. Prints one row per body count, run with the number of threads to
+// use as the only argument (defaults to 1 so the cache effects are not hidden by scaling).
+
+#include "gravity_physics_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace sve;
+
+static SveBodyStore createBodies(size_t count) {
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> position{-1.f, 1.f};
+    SveBodyStore bodies{};
+    bodies.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        bodies.addBody({position(rng), position(rng)}, {}, 1.f);
+    }
+    return bodies;
+}
+
+// median seconds per step over a few trials
+static double timeSolver(ForceSolver solver, size_t count, unsigned int threads) {
+    GravityPhysicsSystem system{0.81f, threads};
+    system.solver = solver;
+    SveBodyStore bodies = createBodies(count);
+
+    // aim for roughly 5e7 pair interactions per trial
+    const size_t steps = std::max<size_t>(1, 100000000 / (count * count));
+    system.update(bodies, 1e-6f, 1);  // warmup
+
+    std::vector<double> trials;
+    for (int trial = 0; trial < 3; trial++) {
+        auto start = std::chrono::steady_clock::now();
+        system.update(bodies, 1e-6f * steps, static_cast<unsigned int>(steps));
+        auto end = std::chrono::steady_clock::now();
+        trials.push_back(std::chrono::duration<double>(end - start).count() / steps);
+    }
+    std::sort(trials.begin(), trials.end());
+    return trials[trials.size() / 2];
+}
+
+int main(int argc, char **argv) {
+    unsigned int threads = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 1;
+    GravityPhysicsSystem probe{0.81f, 1};
+
+    std::printf("l1 data cache %zu bytes, tile size %zu bodies, %u threads\n",
+                detectL1DataCacheSize(), probe.tileSize, threads);
+    std::printf("%10s %14s %14s %9s\n", "bodies", "pair loop ms", "tiled ms", "speedup");
+
+    for (size_t count = 256; count <= 16384; count *= 2) {
+        double plain = timeSolver(ForceSolver::DirectSum, count, threads);
+        double tiled = timeSolver(ForceSolver::DirectSumTiled, count, threads);
+        std::printf("%10zu %14.3f %14.3f %8.2fx\n", count, plain * 1e3, tiled * 1e3, plain / tiled);
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "fft.hpp"
+
+// std
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace sve {
+
+void Fft::resize(size_t size) {
+    assert(size > 0 && (size & (size - 1)) == 0 && "fft size has to be a power of two");
+    if (size == bitReversed.size()) return;
+
+    int bits = 0;
+    while ((size_t{1} << bits) < size) bits++;
+
+    bitReversed.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        uint32_t reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        bitReversed[i] = reversed;
+    }
+
+    // twiddles are evaluated in double, summing float angles drifts noticeably for large sizes
+    twiddles.resize(size / 2);
+    for (size_t k = 0; k < size / 2; k++) {
+        double angle = -2.0 * 3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(size);
+        twiddles[k] = {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+    }
+}
+
+void Fft::transform(std::complex<float> *data, bool invert) const {
+    const size_t n = bitReversed.size();
+    for (size_t i = 0; i < n; i++) {
+        if (i < bitReversed[i]) std::swap(data[i], data[bitReversed[i]]);
+    }
+
+    // butterflies of doubling width, a stage of width len uses every (n / len)th twiddle
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const size_t half = len / 2;
+        const size_t twiddleStride = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                std::complex<float> w = twiddles[k * twiddleStride];
+                if (invert) w = std::conj(w);
+
+                const std::complex<float> even = data[start + k];
+                // written out, operator* on std::complex goes through a slow nan checking path
+                const std::complex<float> o = data[start + k + half];
+                const std::complex<float> odd{
+                    o.real() * w.real() - o.imag() * w.imag(), o.real() * w.imag() + o.imag() * w.real()};
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+}  // namespace sve
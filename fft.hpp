@@ -0,0 +1,32 @@
+#pragma once
+
+// std
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sve {
+
+// Iterative radix-2 complex fft with the bit reversal table and twiddle factors precomputed for a
+// single power of two size. Self-contained so the physics code builds without an fft library.
+class Fft {
+   public:
+    explicit Fft(size_t size = 1) { resize(size); }
+
+    // size has to be a power of two, the tables are only rebuilt if it changed
+    void resize(size_t size);
+    size_t size() const { return bitReversed.size(); }
+
+    // in place transforms of size() contiguous values, inverse() does not divide by size()
+    void forward(std::complex<float> *data) const { transform(data, false); }
+    void inverse(std::complex<float> *data) const { transform(data, true); }
+
+   private:
+    void transform(std::complex<float> *data, bool invert) const;
+
+    std::vector<uint32_t> bitReversed;
+    std::vector<std::complex<float>> twiddles;  // exp(-2 pi i k / size) for k < size / 2
+};
+
+}  // namespace sve
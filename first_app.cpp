@@ -1,6 +1,17 @@
 #include "first_app.hpp"
 
+#include "gpu_body_render_system.hpp"
+#include "gpu_gravity_system.hpp"
+#include "gravity_physics_system.hpp"
 #include "simple_render_system.hpp"
+#include "sve_body_store.hpp"
+#include "sve_fixed_timestep.hpp"
+#include "sve_profiler.hpp"
+#include "sve_scenario.hpp"
+#include "sve_simulation_thread.hpp"
+#include "sve_snapshot.hpp"
+#include "sve_thread_pool.hpp"
+#include "vec2_field_system.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -11,84 +22,58 @@
 // std
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <stdexcept>
+#include <utility>
 
 namespace sve {
 
-class GravityPhysicsSystem {
-   public:
-    GravityPhysicsSystem(float strength) : strengthGravity{strength} {}
-
-    const float strengthGravity;
-
-    // dt stands for delta time, and specifies the amount of time to advance the simulation
-    // substeps is how many intervals to divide the forward time step in. More substeps result in a
-    // more stable simulation, but takes longer to compute
-    void update(std::vector<SveGameObject>& objs, float dt, unsigned int substeps = 1) {
-        const float stepDelta = dt / substeps;
-        for (int i = 0; i < substeps; i++) {
-            stepSimulation(objs, stepDelta);
-        }
+// colors handed out to bodies by id, the first two match the original red and blue pair
+static const std::array<glm::vec3, 4> BODY_COLORS{
+    glm::vec3{1.0f, 0.0f, 0.0f},
+    glm::vec3{0.0f, 0.0f, 1.0f},
+    glm::vec3{0.0f, 1.0f, 0.0f},
+    glm::vec3{1.0f, 1.0f, 0.0f}};
+
+// creates a render object for every body in the store, the store stays the source of truth
+std::vector<SveGameObject> createBodyObjects(const SveBodyStore& bodies, std::shared_ptr<SveModel> model) {
+    std::vector<SveGameObject> objs{};
+    objs.reserve(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        auto obj = SveGameObject::createGameObject();
+        obj.transform2d.scale = glm::vec2{0.05f};
+        obj.transform2d.translation = bodies.position(i);
+        obj.color = BODY_COLORS[bodies.id[i] % BODY_COLORS.size()];
+        obj.rigidBody2d.velocity = bodies.velocity(i);
+        obj.rigidBody2d.mass = bodies.mass[i];
+        obj.model = model;
+        objs.push_back(std::move(obj));
     }
+    return objs;
+}
 
-    glm::vec2 computeForce(SveGameObject& fromObj, SveGameObject& toObj) const {
-        auto offset = fromObj.transform2d.translation - toObj.transform2d.translation;
-        float distanceSquared = glm::dot(offset, offset);
-
-        // clown town - just going to return 0 if objects are too close together...
-        if (glm::abs(distanceSquared) < 1e-10f) {
-            return {.0f, .0f};
-        }
-
-        float force =
-            strengthGravity * toObj.rigidBody2d.mass * fromObj.rigidBody2d.mass / distanceSquared;
-        return force * offset / glm::sqrt(distanceSquared);
+// Writes simulated positions back into the render objects, only what rendering needs is copied.
+// Blends between the states before and after the last tick, alpha being how far real time is past it
+void syncTransforms(const SimulationSnapshot& snapshot, float alpha, std::vector<SveGameObject>& objs) {
+    for (size_t i = 0; i < objs.size(); i++) {
+        objs[i].transform2d.translation = glm::mix(snapshot.previousPositions[i], snapshot.positions[i], alpha);
     }
+}
 
-   private:
-    void stepSimulation(std::vector<SveGameObject>& physicsObjs, float dt) {
-        // Loops through all pairs of objects and applies attractive force between them
-        for (auto iterA = physicsObjs.begin(); iterA != physicsObjs.end(); ++iterA) {
-            auto& objA = *iterA;
-            for (auto iterB = iterA; iterB != physicsObjs.end(); ++iterB) {
-                if (iterA == iterB) continue;
-                auto& objB = *iterB;
-
-                auto force = computeForce(objA, objB);
-                objA.rigidBody2d.velocity += dt * -force / objA.rigidBody2d.mass;
-                objB.rigidBody2d.velocity += dt * force / objB.rigidBody2d.mass;
-            }
-        }
-
-        // update each objects position based on its final velocity
-        for (auto& obj : physicsObjs) {
-            obj.transform2d.translation += dt * obj.rigidBody2d.velocity;
-        }
+void syncFieldTransforms(const SimulationSnapshot& snapshot, std::vector<SveGameObject>& objs) {
+    for (size_t i = 0; i < objs.size(); i++) {
+        objs[i].transform2d.scale.x = snapshot.fieldScale[i];
+        objs[i].transform2d.rotation = snapshot.fieldRotation[i];
     }
-};
-
-class Vec2FieldSystem {
-   public:
-    void update(
-        const GravityPhysicsSystem& physicsSystem,
-        std::vector<SveGameObject>& physicsObjs,
-        std::vector<SveGameObject>& vectorField) {
-        // For each field line we caluclate the net graviation force for that point in space
-        for (auto& vf : vectorField) {
-            glm::vec2 direction{};
-            for (auto& obj : physicsObjs) {
-                direction += physicsSystem.computeForce(obj, vf);
-            }
+}
 
-            // This scales the length of the field line based on the log of the length
-            // values were chosen just through trial and error based on what i liked the look
-            // of and then the field line is rotated to point in the direction of the field
-            vf.transform2d.scale.x =
-                0.005f + 0.045f * glm::clamp(glm::log(glm::length(direction) + 1) / 3.f, 0.f, 1.f);
-            vf.transform2d.rotation = atan2(direction.y, direction.x);
-        }
+void syncFieldTransforms(const Vec2FieldSamples& field, std::vector<SveGameObject>& objs) {
+    for (size_t i = 0; i < objs.size(); i++) {
+        objs[i].transform2d.scale.x = field.scale[i];
+        objs[i].transform2d.rotation = field.rotation[i];
     }
-};
+}
 
 std::unique_ptr<SveModel> createSquareModel(SveDevice& device, glm::vec2 offset) {
     std::vector<SveModel::Vertex> vertices = {
@@ -122,7 +107,13 @@ std::unique_ptr<SveModel> createCircleModel(SveDevice& device, unsigned int numS
     return std::make_unique<SveModel>(device, vertices);
 }
 
-FirstApp::FirstApp() { loadGameObjects(); }
+FirstApp::FirstApp(std::string scenarioPath, std::string statePath, bool gpuPhysics, bool parallelDraw)
+    : scenarioPath{std::move(scenarioPath)},
+      statePath{std::move(statePath)},
+      gpuPhysics{gpuPhysics},
+      parallelDraw{parallelDraw} {
+    loadGameObjects();
+}
 
 FirstApp::~FirstApp() {}
 
@@ -131,59 +122,213 @@ void FirstApp::run() {
     std::shared_ptr<SveModel> squareModel = createSquareModel(sveDevice, {0.5f, 0.0f});  // offset by 0.5 so rotation is at edge rather than center
     std::shared_ptr<SveModel> circleModel = createCircleModel(sveDevice, 64);
 
-    // create physics objects
-    std::vector<SveGameObject> physicsObjects{};
-    auto red = SveGameObject::createGameObject();
-    red.transform2d.scale = glm::vec2{0.05f};
-    red.transform2d.translation = glm::vec2{0.5f, 0.5f};
-    red.color = {1.0f, 0.0f, 0.0f};
-    red.rigidBody2d.velocity = {-0.5f, 0.0f};
-    red.model = circleModel;
-    physicsObjects.push_back(std::move(red));
-
-    auto blue = SveGameObject::createGameObject();
-    blue.transform2d.scale = glm::vec2{0.05f};
-    blue.transform2d.translation = glm::vec2{-0.45f, -0.25f};
-    blue.color = {0.0f, 0.0f, 1.0f};
-    blue.rigidBody2d.velocity = {0.5f, 0.0f};
-    blue.model = circleModel;
-    physicsObjects.push_back(std::move(blue));
+    const Scenario scenario = Scenario::load(scenarioPath);
+    GravityPhysicsSystem gravitySystem{scenario.strength, scenario.threadCount};
+    scenario.configure(gravitySystem);
+    Vec2FieldSystem vecFieldSystem{};
+
+    // the systems run on flat arrays, the game objects only hold what is needed to draw them
+    SveBodyStore bodies{};
+    if (!statePath.empty()) {
+        readSnapshot(statePath, bodies);
+    } else {
+        scenario.generateBodies(gravitySystem.getThreadPool(), bodies);
+    }
+    std::vector<SveGameObject> physicsObjects = createBodyObjects(bodies, circleModel);
 
     // create vector field
+    Vec2FieldSamples fieldSamples{};
+    scenario.createFieldSamples(fieldSamples);
     std::vector<SveGameObject> vectorField{};
-    int gridCount = 40;
-    for (int i = 0; i < gridCount; i++) {
-        for (int j = 0; j < gridCount; j++) {
-            auto vf = SveGameObject::createGameObject();
-            vf.transform2d.scale = glm::vec2{0.005f};
-            vf.transform2d.translation = {
-                -1.0f + (i + 0.5f) * 2.0f / gridCount,
-                -1.0f + (j + 0.5f) * 2.0f / gridCount};
-            vf.color = glm::vec3(1.0f);
-            vf.model = squareModel;
-            vectorField.push_back(std::move(vf));
+    for (size_t i = 0; i < fieldSamples.size(); i++) {
+        auto vf = SveGameObject::createGameObject();
+        vf.transform2d.scale = glm::vec2{0.005f};
+        vf.transform2d.translation = {fieldSamples.positionX[i], fieldSamples.positionY[i]};
+        vf.color = glm::vec3(1.0f);
+        vf.model = squareModel;
+        vectorField.push_back(std::move(vf));
+    }
+
+    if (gpuPhysics) {
+        runGpuPhysics(scenario, gravitySystem, *circleModel, vectorField, bodies, fieldSamples);
+        return;
+    }
+
+    SimpleRenderSystem simpleRenderSystem{sveDevice, sveRenderer.getSwapChainRenderPass()};
+    // there is no camera yet, the view is all of clip space and only bodies that left it are culled
+    const SimpleRenderSystem::CullView view{};
+    SimpleRenderSystem::CulledDraws physicsDraws{};
+    // the field's glyphs turn every frame, but their count and model never change
+    const uint32_t fieldDrawList = simpleRenderSystem.createStaticDrawList();
+    // a thread per core records when drawing object by object, otherwise there are no workers
+    SveThreadPool recordThreadPool{parallelDraw ? 0u : 1u};
+
+    // From here on the systems and stores above belong to the simulation thread, it runs them at the
+    // scenario's tick rate in real time whatever rate frames are presented at. This thread only draws
+    // the snapshots it publishes, so the next state is simulated while this one is recorded and presented
+    SveSimulationThread simulationThread{
+        gravitySystem, vecFieldSystem, bodies, fieldSamples, scenario.tickDelta, scenario.substeps};
+
+    // physics and field updates are timed on the simulation thread, they show up in the same report
+    SVE_PROFILE_THREAD("render");
+    while (!sveWindow.shouldClose()) {
+        SVE_PROFILE_FRAME();
+        SVE_PROFILE_SCOPE("frame");
+        {
+            SVE_PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
+
+        VkCommandBuffer commandBuffer;
+        {
+            // includes waiting on the fence of the frame in flight and acquiring the image
+            SVE_PROFILE_SCOPE("beginFrame");
+            commandBuffer = sveRenderer.beginFrame();
+        }
+        if (commandBuffer) {
+            {
+                SVE_PROFILE_SCOPE("syncTransforms");
+                const SimulationSnapshot& snapshot = simulationThread.latest();
+                float alpha = simulationThread.interpolationAlpha(snapshot, std::chrono::steady_clock::now());
+                syncTransforms(snapshot, alpha, physicsObjects);
+                syncFieldTransforms(snapshot, vectorField);
+            }
+
+            FrameInfo frameInfo{
+                sveRenderer.getFrameIndex(),
+                commandBuffer,
+                sveRenderer.getFrameRing(),
+                sveRenderer.getSecondaryCommandBuffers()};
+
+            // The field's cached draws are secondary command buffers, so everything in the render
+            // pass is. Culling is a compute pass, it has to be recorded before the render pass begins
+            if (!parallelDraw) {
+                SVE_PROFILE_SCOPE("recordCull");
+                uint32_t cullTimer = sveRenderer.beginGpuTimer(commandBuffer, "gpu SimpleRenderSystem::recordCull");
+                simpleRenderSystem.recordCull(frameInfo, physicsObjects, view, physicsDraws);
+                sveRenderer.endGpuTimer(commandBuffer, cullTimer);
+            }
+
+            // render system
+            sveRenderer.beginSwapChainRenderPass(commandBuffer, recordThreadPool.size());
+            {
+                SVE_PROFILE_SCOPE("renderGameObjects");
+                if (parallelDraw) {
+                    simpleRenderSystem.renderGameObjectsParallel(frameInfo, recordThreadPool, physicsObjects);
+                } else {
+                    VkCommandBuffer secondary = frameInfo.secondaryCommandBuffers.begin(0);
+                    FrameInfo secondaryInfo{
+                        frameInfo.frameIndex, secondary, frameInfo.frameRing, frameInfo.secondaryCommandBuffers};
+                    simpleRenderSystem.renderCulled(secondaryInfo, physicsDraws);
+                    frameInfo.secondaryCommandBuffers.end(secondary);
+                    vkCmdExecuteCommands(commandBuffer, 1, &secondary);
+                }
+                simpleRenderSystem.renderStaticGameObjects(frameInfo, fieldDrawList, vectorField);
+            }
+            sveRenderer.endSwapChainRenderPass(commandBuffer);
+            {
+                SVE_PROFILE_SCOPE("endFrame");
+                sveRenderer.endFrame();
+            }
         }
     }
 
-    GravityPhysicsSystem gravitySystem{0.81f};
+    vkDeviceWaitIdle(sveDevice.device());
+}
+
+void FirstApp::runGpuPhysics(
+    const Scenario& scenario,
+    GravityPhysicsSystem& gravitySystem,
+    SveModel& bodyModel,
+    std::vector<SveGameObject>& vectorField,
+    SveBodyStore& bodies,
+    Vec2FieldSamples& fieldSamples) {
+    // the cpu system is only here for the field, which borrows its constants and workers
     Vec2FieldSystem vecFieldSystem{};
+    GpuGravitySystem gpuGravitySystem{sveDevice, gravitySystem.strengthGravity, bodies};
 
     SimpleRenderSystem simpleRenderSystem{sveDevice, sveRenderer.getSwapChainRenderPass()};
+    GpuBodyRenderSystem gpuBodyRenderSystem{sveDevice, sveRenderer.getSwapChainRenderPass()};
+    const uint32_t fieldDrawList = simpleRenderSystem.createStaticDrawList();
+
+    // the compute shader only does semi-implicit euler, a scenario asking for more still runs but with
+    // less accuracy than on the cpu
+    if (scenario.integrator != Integrator::SemiImplicitEuler) {
+        std::fprintf(stderr, "warning: the gpu integrates with semi-implicit euler, ignoring the scenario's integrator\n");
+    }
+    SveFixedTimestep timestep{scenario.tickDelta};
+    const unsigned int substeps = scenario.substeps;
+    auto currentTime = std::chrono::high_resolution_clock::now();
+
+    // bodies only come back to the cpu for the field, a few times a second is plenty for that
+    const unsigned int fieldReadBackTicks = 15;
+    unsigned int ticksSinceReadBack = fieldReadBackTicks;
 
+    SVE_PROFILE_THREAD("render");
     while (!sveWindow.shouldClose()) {
-        glfwPollEvents();
+        SVE_PROFILE_FRAME();
+        SVE_PROFILE_SCOPE("frame");
+        {
+            SVE_PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
 
-        if (auto commandBuffer = sveRenderer.beginFrame()) {
-            // update systems
-            gravitySystem.update(physicsObjects, 1.f / 60, 5);
-            vecFieldSystem.update(gravitySystem, physicsObjects, vectorField);
+        auto newTime = std::chrono::high_resolution_clock::now();
+        float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+        currentTime = newTime;
 
-            // render system
-            sveRenderer.beginSwapChainRenderPass(commandBuffer);
-            simpleRenderSystem.renderGameObjects(commandBuffer, physicsObjects);
-            simpleRenderSystem.renderGameObjects(commandBuffer, vectorField);
+        if (ticksSinceReadBack >= fieldReadBackTicks) {
+            {
+                SVE_PROFILE_SCOPE("GpuGravitySystem::readBack");
+                gpuGravitySystem.readBack(bodies);
+            }
+            {
+                SVE_PROFILE_SCOPE("Vec2FieldSystem::update");
+                vecFieldSystem.update(gravitySystem, bodies, fieldSamples);
+            }
+            syncFieldTransforms(fieldSamples, vectorField);
+            ticksSinceReadBack = 0;
+        }
+
+        VkCommandBuffer commandBuffer;
+        {
+            SVE_PROFILE_SCOPE("beginFrame");
+            commandBuffer = sveRenderer.beginFrame();
+        }
+        if (commandBuffer) {
+            unsigned int ticks = timestep.advance(frameTime);
+            ticksSinceReadBack += ticks;
+            uint32_t computeTimer = sveRenderer.beginGpuTimer(commandBuffer, "gpu GpuGravitySystem::recordUpdate");
+            gpuGravitySystem.recordUpdate(commandBuffer, timestep.getTickDelta() / substeps, ticks * substeps);
+            sveRenderer.endGpuTimer(commandBuffer, computeTimer);
+
+            FrameInfo frameInfo{
+                sveRenderer.getFrameIndex(),
+                commandBuffer,
+                sveRenderer.getFrameRing(),
+                sveRenderer.getSecondaryCommandBuffers()};
+
+            // the field's cached draws are secondary command buffers, so the bodies go in one too
+            sveRenderer.beginSwapChainRenderPass(commandBuffer, 1);
+            {
+                SVE_PROFILE_SCOPE("renderGameObjects");
+                VkCommandBuffer secondary = frameInfo.secondaryCommandBuffers.begin(0);
+                gpuBodyRenderSystem.renderBodies(
+                    secondary,
+                    bodyModel,
+                    gpuGravitySystem.getBodyBuffer(),
+                    gpuGravitySystem.getBodyCount(),
+                    glm::vec2{0.05f},
+                    {1.0f, 0.0f, 0.0f});
+                frameInfo.secondaryCommandBuffers.end(secondary);
+                vkCmdExecuteCommands(commandBuffer, 1, &secondary);
+                simpleRenderSystem.renderStaticGameObjects(frameInfo, fieldDrawList, vectorField);
+            }
             sveRenderer.endSwapChainRenderPass(commandBuffer);
-            sveRenderer.endFrame();
+            {
+                SVE_PROFILE_SCOPE("endFrame");
+                sveRenderer.endFrame();
+            }
         }
     }
 
@@ -1,12 +1,17 @@
 #pragma once
 
+#include "gravity_physics_system.hpp"
+#include "sve_body_store.hpp"
 #include "sve_device.hpp"
 #include "sve_game_object.hpp"
 #include "sve_renderer.hpp"
+#include "sve_scenario.hpp"
 #include "sve_window.hpp"
+#include "vec2_field_system.hpp"
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace sve {
@@ -15,7 +20,17 @@ class FirstApp {
     static constexpr int WIDTH = 800;
     static constexpr int HEIGHT = 600;
 
-    FirstApp();
+    static constexpr const char *DEFAULT_SCENARIO = "scenarios/two_body.scn";
+
+    // scenarioPath sets up the bodies, field and physics. A statePath snapshot replaces the scenario's
+    // bodies, gpuPhysics runs gravity in a compute shader instead of on the simulation thread.
+    // parallelDraw draws the cpu simulated objects one by one, recorded on every core, instead of
+    // culled and instanced
+    explicit FirstApp(
+        std::string scenarioPath = DEFAULT_SCENARIO,
+        std::string statePath = {},
+        bool gpuPhysics = false,
+        bool parallelDraw = false);
     ~FirstApp();
 
     FirstApp(const FirstApp &) = delete;
@@ -25,6 +40,18 @@ class FirstApp {
 
    private:
     void loadGameObjects();
+    void runGpuPhysics(
+        const Scenario &scenario,
+        GravityPhysicsSystem &gravitySystem,
+        SveModel &bodyModel,
+        std::vector<SveGameObject> &vectorField,
+        SveBodyStore &bodies,
+        Vec2FieldSamples &fieldSamples);
+
+    const std::string scenarioPath;
+    const std::string statePath;
+    const bool gpuPhysics;
+    const bool parallelDraw;
 
     SveWindow sveWindow{WIDTH, HEIGHT, "Gravity Vector Field"};
     SveDevice sveDevice{sveWindow};
@@ -0,0 +1,90 @@
+#include "gpu_body_render_system.hpp"
+
+#include "gpu_gravity_system.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace sve {
+
+// same layout as SimplePushConstantData, the fragment shader is shared with SimpleRenderSystem
+struct GpuBodyPushConstantData {
+    glm::mat2 transform{1.f};
+    glm::vec2 offset;
+    alignas(16) glm::vec3 color;
+};
+
+GpuBodyRenderSystem::GpuBodyRenderSystem(SveDevice& device, VkRenderPass renderPass) : sveDevice{device} {
+    createPipelineLayout();
+    createPipeline(renderPass);
+}
+
+GpuBodyRenderSystem::~GpuBodyRenderSystem() { vkDestroyPipelineLayout(sveDevice.device(), pipelineLayout, nullptr); }
+
+void GpuBodyRenderSystem::createPipelineLayout() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.size = sizeof(GpuBodyPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 0;
+    pipelineLayoutInfo.pSetLayouts = nullptr;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(sveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+}
+
+void GpuBodyRenderSystem::createPipeline(VkRenderPass renderPass) {
+    assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+    PipelineConfigInfo pipelineConfig{};
+    SvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+
+    // binding 1 steps once per instance through the GpuBody array
+    pipelineConfig.bindingDescriptions.push_back({1, sizeof(GpuBody), VK_VERTEX_INPUT_RATE_INSTANCE});
+    pipelineConfig.attributeDescriptions.push_back({2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(GpuBody, position)});
+
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+    svePipeline = std::make_unique<SvePipeline>(
+        sveDevice,
+        "shaders/gpu_body.vert.spv",
+        "shaders/simple_shader.frag.spv",
+        pipelineConfig);
+}
+
+void GpuBodyRenderSystem::renderBodies(
+    VkCommandBuffer commandBuffer,
+    SveModel& model,
+    VkBuffer bodyBuffer,
+    uint32_t bodyCount,
+    glm::vec2 scale,
+    glm::vec3 color) {
+    if (bodyCount == 0) return;
+
+    svePipeline->bind(commandBuffer);
+
+    GpuBodyPushConstantData push{};
+    push.transform = glm::mat2{{scale.x, .0f}, {.0f, scale.y}};
+    push.color = color;
+    vkCmdPushConstants(
+        commandBuffer,
+        pipelineLayout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(GpuBodyPushConstantData),
+        &push);
+
+    model.bind(commandBuffer);
+    VkBuffer buffers[] = {bodyBuffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+    model.draw(commandBuffer, bodyCount);
+}
+
+}  // namespace sve
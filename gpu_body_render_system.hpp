@@ -0,0 +1,45 @@
+#pragma once
+
+#include "sve_device.hpp"
+#include "sve_model.hpp"
+#include "sve_pipeline.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+
+namespace sve {
+
+// Draws one instance of a model per body of a GpuGravitySystem, positions come straight from its
+// storage buffer so they never pass through the cpu
+class GpuBodyRenderSystem {
+   public:
+    GpuBodyRenderSystem(SveDevice &device, VkRenderPass renderPass);
+    ~GpuBodyRenderSystem();
+
+    GpuBodyRenderSystem(const GpuBodyRenderSystem &) = delete;
+    GpuBodyRenderSystem &operator=(const GpuBodyRenderSystem &) = delete;
+
+    void renderBodies(
+        VkCommandBuffer commandBuffer,
+        SveModel &model,
+        VkBuffer bodyBuffer,
+        uint32_t bodyCount,
+        glm::vec2 scale,
+        glm::vec3 color);
+
+   private:
+    void createPipelineLayout();
+    void createPipeline(VkRenderPass renderPass);
+
+    SveDevice &sveDevice;
+
+    std::unique_ptr<SvePipeline> svePipeline;
+    VkPipelineLayout pipelineLayout;
+};
+
+}  // namespace sve
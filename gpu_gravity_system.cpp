@@ -0,0 +1,247 @@
+#include "gpu_gravity_system.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace sve {
+
+struct GravityPushConstantData {
+    uint32_t bodyCount;
+    float dt;
+    float strength;
+};
+
+GpuGravitySystem::GpuGravitySystem(SveDevice &device, float strength, const SveBodyStore &bodies)
+    : strengthGravity{strength}, sveDevice{device}, bodyCount{static_cast<uint32_t>(bodies.size())} {
+    createBuffers(bodies);
+    createDescriptorSets();
+    createPipelineLayout();
+    computePipeline = std::make_unique<SveComputePipeline>(sveDevice, "shaders/gravity.comp.spv", pipelineLayout);
+}
+
+GpuGravitySystem::~GpuGravitySystem() {
+    vkDestroyPipelineLayout(sveDevice.device(), pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(sveDevice.device(), descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(sveDevice.device(), descriptorSetLayout, nullptr);
+    for (int i = 0; i < 2; i++) {
+        vkDestroyBuffer(sveDevice.device(), bodyBuffers[i], nullptr);
+        vkFreeMemory(sveDevice.device(), bodyBufferMemory[i], nullptr);
+    }
+}
+
+void GpuGravitySystem::createBuffers(const SveBodyStore &bodies) {
+    // an empty buffer is not allowed, keep room for one body
+    VkDeviceSize bufferSize = sizeof(GpuBody) * std::max<VkDeviceSize>(bodyCount, 1);
+    for (int i = 0; i < 2; i++) {
+        sveDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            bodyBuffers[i],
+            bodyBufferMemory[i]);
+    }
+
+    std::vector<GpuBody> gpuBodies(bodyCount);
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        gpuBodies[i] = {bodies.position(i), bodies.velocity(i), bodies.mass[i], 0.f};
+    }
+
+    // device local memory is not mappable everywhere, go through a staging buffer
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    sveDevice.createBuffer(
+        bufferSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingBufferMemory);
+
+    void *data;
+    vkMapMemory(sveDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(data, gpuBodies.data(), sizeof(GpuBody) * bodyCount);
+    vkUnmapMemory(sveDevice.device(), stagingBufferMemory);
+
+    sveDevice.copyBuffer(stagingBuffer, bodyBuffers[current], bufferSize);
+
+    vkDestroyBuffer(sveDevice.device(), stagingBuffer, nullptr);
+    vkFreeMemory(sveDevice.device(), stagingBufferMemory, nullptr);
+}
+
+void GpuGravitySystem::createDescriptorSets() {
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(sveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 4;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 2;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(sveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    VkDescriptorSetLayout setLayouts[2] = {descriptorSetLayout, descriptorSetLayout};
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 2;
+    allocInfo.pSetLayouts = setLayouts;
+    if (vkAllocateDescriptorSets(sveDevice.device(), &allocInfo, descriptorSets) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+
+    for (uint32_t i = 0; i < 2; i++) {
+        VkDescriptorBufferInfo bufferInfos[2]{};
+        bufferInfos[0].buffer = bodyBuffers[i];
+        bufferInfos[0].range = VK_WHOLE_SIZE;
+        bufferInfos[1].buffer = bodyBuffers[1 - i];
+        bufferInfos[1].range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet writes[2]{};
+        for (uint32_t b = 0; b < 2; b++) {
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = descriptorSets[i];
+            writes[b].dstBinding = b;
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &bufferInfos[b];
+        }
+        vkUpdateDescriptorSets(sveDevice.device(), 2, writes, 0, nullptr);
+    }
+}
+
+void GpuGravitySystem::createPipelineLayout() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.size = sizeof(GravityPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(sveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+}
+
+void GpuGravitySystem::recordUpdate(VkCommandBuffer commandBuffer, float dt, unsigned int steps) {
+    if (bodyCount == 0 || steps == 0) return;
+
+    computePipeline->bind(commandBuffer);
+
+    GravityPushConstantData push{};
+    push.bodyCount = bodyCount;
+    push.dt = dt;
+    push.strength = strengthGravity;
+    vkCmdPushConstants(
+        commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GravityPushConstantData), &push);
+
+    // Before every dispatch the previous one has to be done writing. The first one in a command
+    // buffer also waits for the upload, and for earlier submissions still drawing from or copying
+    // the buffer it is about to overwrite
+    VkMemoryBarrier computeBarrier{};
+    computeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    computeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    computeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    for (unsigned int step = 0; step < steps; step++) {
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            &computeBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[current], 0, nullptr);
+        vkCmdDispatch(commandBuffer, (bodyCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        current = 1 - current;
+    }
+
+    VkMemoryBarrier drawBarrier{};
+    drawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    drawBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &drawBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+void GpuGravitySystem::update(float dt, unsigned int steps) {
+    VkCommandBuffer commandBuffer = sveDevice.beginSingleTimeCommands();
+    recordUpdate(commandBuffer, dt, steps);
+    sveDevice.endSingleTimeCommands(commandBuffer);
+}
+
+void GpuGravitySystem::readBack(SveBodyStore &bodies) {
+    VkDeviceSize bufferSize = sizeof(GpuBody) * std::max<VkDeviceSize>(bodyCount, 1);
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    sveDevice.createBuffer(
+        bufferSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingBufferMemory);
+
+    // copyBuffer waits for the queue to go idle, which includes every submitted update
+    sveDevice.copyBuffer(bodyBuffers[current], stagingBuffer, bufferSize);
+
+    std::vector<GpuBody> gpuBodies(bodyCount);
+    void *data;
+    vkMapMemory(sveDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(gpuBodies.data(), data, sizeof(GpuBody) * bodyCount);
+    vkUnmapMemory(sveDevice.device(), stagingBufferMemory);
+
+    vkDestroyBuffer(sveDevice.device(), stagingBuffer, nullptr);
+    vkFreeMemory(sveDevice.device(), stagingBufferMemory, nullptr);
+
+    bodies.resize(bodyCount);
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        bodies.positionX[i] = gpuBodies[i].position.x;
+        bodies.positionY[i] = gpuBodies[i].position.y;
+        bodies.velocityX[i] = gpuBodies[i].velocity.x;
+        bodies.velocityY[i] = gpuBodies[i].velocity.y;
+        bodies.mass[i] = gpuBodies[i].mass;
+    }
+}
+
+}  // namespace sve
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sve_body_store.hpp"
+#include "sve_compute_pipeline.hpp"
+#include "sve_device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+
+namespace sve {
+
+// layout of Body in shaders/gravity.comp (std430), the padding keeps the c++ and glsl sizes equal
+struct GpuBody {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    float mass;
+    float padding;
+};
+
+// Direct sum gravity in a compute shader. Bodies live in two device local storage buffers that
+// the dispatches ping-pong between, so any number of substeps stay on the device. The buffer with
+// the latest state doubles as an instance vertex buffer for drawing, the cpu only sees the bodies
+// again when readBack() is called.
+class GpuGravitySystem {
+   public:
+    static constexpr uint32_t WORKGROUP_SIZE = 128;
+
+    GpuGravitySystem(SveDevice &device, float strength, const SveBodyStore &bodies);
+    ~GpuGravitySystem();
+
+    GpuGravitySystem(const GpuGravitySystem &) = delete;
+    GpuGravitySystem &operator=(const GpuGravitySystem &) = delete;
+
+    const float strengthGravity;
+
+    // Records steps dispatches of dt each into commandBuffer, outside of a render pass. Ends with a
+    // barrier that makes the results visible to vertex input and transfers
+    void recordUpdate(VkCommandBuffer commandBuffer, float dt, unsigned int steps);
+
+    // same as recordUpdate in a command buffer of its own, blocks until the device is done
+    void update(float dt, unsigned int steps);
+
+    // Copies the latest state into bodies, blocks until the device is done. Only sees work that was
+    // already submitted, so call it between frames rather than while one is being recorded
+    void readBack(SveBodyStore &bodies);
+
+    // buffer holding the state after the last recorded update, GpuBody per body
+    VkBuffer getBodyBuffer() const { return bodyBuffers[current]; }
+    uint32_t getBodyCount() const { return bodyCount; }
+
+   private:
+    void createBuffers(const SveBodyStore &bodies);
+    void createDescriptorSets();
+    void createPipelineLayout();
+
+    SveDevice &sveDevice;
+    uint32_t bodyCount;
+
+    VkBuffer bodyBuffers[2];
+    VkDeviceMemory bodyBufferMemory[2];
+    uint32_t current{0};  // which of bodyBuffers holds the latest state
+
+    // descriptorSets[i] reads bodyBuffers[i] and writes the other one
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSets[2];
+
+    VkPipelineLayout pipelineLayout;
+    std::unique_ptr<SveComputePipeline> computePipeline;
+};
+
+}  // namespace sve
@@ -0,0 +1,224 @@
+#include "gravity_kernels.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace sve {
+
+// same cutoff as GravityPhysicsSystem::computeForce
+static constexpr float MIN_DISTANCE_SQUARED = 1e-10f;
+
+static void computeAccelerationsScalar(
+    float strength,
+    const float *sourceX,
+    const float *sourceY,
+    const float *sourceMass,
+    size_t sourceCount,
+    const float *targetX,
+    const float *targetY,
+    float *accX,
+    float *accY,
+    size_t targetCount) {
+    for (size_t t = 0; t < targetCount; t++) {
+        float ax = 0.f;
+        float ay = 0.f;
+        for (size_t s = 0; s < sourceCount; s++) {
+            float dx = sourceX[s] - targetX[t];
+            float dy = sourceY[s] - targetY[t];
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared < MIN_DISTANCE_SQUARED) continue;
+
+            float invDistance = 1.f / std::sqrt(distanceSquared);
+            float weight = sourceMass[s] * invDistance * invDistance * invDistance;
+            ax += weight * dx;
+            ay += weight * dy;
+        }
+        accX[t] = strength * ax;
+        accY[t] = strength * ay;
+    }
+}
+
+#ifdef SVE_X86_SIMD
+
+__attribute__((target("avx2,fma"))) static void computeAccelerationsAvx2(
+    float strength,
+    const float *sourceX,
+    const float *sourceY,
+    const float *sourceMass,
+    size_t sourceCount,
+    const float *targetX,
+    const float *targetY,
+    float *accX,
+    float *accY,
+    size_t targetCount) {
+    const __m256 minDistanceSquared = _mm256_set1_ps(MIN_DISTANCE_SQUARED);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 g = _mm256_set1_ps(strength);
+
+    size_t t = 0;
+    for (; t + 8 <= targetCount; t += 8) {
+        const __m256 tx = _mm256_loadu_ps(targetX + t);
+        const __m256 ty = _mm256_loadu_ps(targetY + t);
+        __m256 ax = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps();
+
+        for (size_t s = 0; s < sourceCount; s++) {
+            const __m256 dx = _mm256_sub_ps(_mm256_set1_ps(sourceX[s]), tx);
+            const __m256 dy = _mm256_sub_ps(_mm256_set1_ps(sourceY[s]), ty);
+            const __m256 distanceSquared = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+            // rsqrt is only good to 12 bits, one newton step brings it close to full precision
+            __m256 inv = _mm256_rsqrt_ps(distanceSquared);
+            inv = _mm256_mul_ps(
+                inv,
+                _mm256_fnmadd_ps(_mm256_mul_ps(half, distanceSquared), _mm256_mul_ps(inv, inv), threeHalves));
+
+            // too close pairs are masked out instead of branched around, this also clears the
+            // inf/nan that rsqrt produces for a target acting on itself
+            const __m256 mask = _mm256_cmp_ps(distanceSquared, minDistanceSquared, _CMP_GE_OQ);
+            __m256 weight = _mm256_mul_ps(_mm256_set1_ps(sourceMass[s]), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+            weight = _mm256_and_ps(weight, mask);
+
+            ax = _mm256_fmadd_ps(weight, dx, ax);
+            ay = _mm256_fmadd_ps(weight, dy, ay);
+        }
+
+        _mm256_storeu_ps(accX + t, _mm256_mul_ps(g, ax));
+        _mm256_storeu_ps(accY + t, _mm256_mul_ps(g, ay));
+    }
+
+    if (t < targetCount) {
+        computeAccelerationsScalar(
+            strength, sourceX, sourceY, sourceMass, sourceCount,
+            targetX + t, targetY + t, accX + t, accY + t, targetCount - t);
+    }
+}
+
+__attribute__((target("avx512f"))) static void computeAccelerationsAvx512(
+    float strength,
+    const float *sourceX,
+    const float *sourceY,
+    const float *sourceMass,
+    size_t sourceCount,
+    const float *targetX,
+    const float *targetY,
+    float *accX,
+    float *accY,
+    size_t targetCount) {
+    const __m512 minDistanceSquared = _mm512_set1_ps(MIN_DISTANCE_SQUARED);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 g = _mm512_set1_ps(strength);
+
+    for (size_t t = 0; t < targetCount; t += 16) {
+        // the last block loads and stores through a lane mask instead of a scalar tail loop
+        const size_t remaining = targetCount - t;
+        const __mmask16 lanes = remaining >= 16 ? static_cast<__mmask16>(0xffff)
+                                                : static_cast<__mmask16>((1u << remaining) - 1);
+        const __m512 tx = _mm512_maskz_loadu_ps(lanes, targetX + t);
+        const __m512 ty = _mm512_maskz_loadu_ps(lanes, targetY + t);
+        __m512 ax = _mm512_setzero_ps();
+        __m512 ay = _mm512_setzero_ps();
+
+        for (size_t s = 0; s < sourceCount; s++) {
+            const __m512 dx = _mm512_sub_ps(_mm512_set1_ps(sourceX[s]), tx);
+            const __m512 dy = _mm512_sub_ps(_mm512_set1_ps(sourceY[s]), ty);
+            const __m512 distanceSquared = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+
+            // rsqrt14 is good to 14 bits, one newton step brings it to full precision
+            __m512 inv = _mm512_maskz_rsqrt14_ps(lanes, distanceSquared);
+            inv = _mm512_mul_ps(
+                inv,
+                _mm512_fnmadd_ps(_mm512_mul_ps(half, distanceSquared), _mm512_mul_ps(inv, inv), threeHalves));
+
+            const __mmask16 mask = _mm512_cmp_ps_mask(distanceSquared, minDistanceSquared, _CMP_GE_OQ);
+            const __m512 weight = _mm512_maskz_mul_ps(
+                mask, _mm512_set1_ps(sourceMass[s]), _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv)));
+
+            ax = _mm512_fmadd_ps(weight, dx, ax);
+            ay = _mm512_fmadd_ps(weight, dy, ay);
+        }
+
+        _mm512_mask_storeu_ps(accX + t, lanes, _mm512_mul_ps(g, ax));
+        _mm512_mask_storeu_ps(accY + t, lanes, _mm512_mul_ps(g, ay));
+    }
+}
+
+#endif
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel detected = [] {
+#ifdef SVE_X86_SIMD
+        // __builtin_cpu_supports reads cpuid and also checks that the os saves the wider registers
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::Avx2;
+#endif
+        return SimdLevel::Scalar;
+    }();
+    return detected;
+}
+
+const char *simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx512:
+            return "avx512";
+        case SimdLevel::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+size_t detectL1DataCacheSize() {
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    long size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    if (size > 0) return static_cast<size_t>(size);
+#endif
+    return 32 * 1024;
+}
+
+void computeAccelerations(
+    SimdLevel level,
+    float strength,
+    const float *sourceX,
+    const float *sourceY,
+    const float *sourceMass,
+    size_t sourceCount,
+    const float *targetX,
+    const float *targetY,
+    float *accX,
+    float *accY,
+    size_t targetCount) {
+    level = std::min(level, detectSimdLevel());
+
+    switch (level) {
+#ifdef SVE_X86_SIMD
+        case SimdLevel::Avx512:
+            computeAccelerationsAvx512(
+                strength, sourceX, sourceY, sourceMass, sourceCount, targetX, targetY, accX, accY, targetCount);
+            return;
+        case SimdLevel::Avx2:
+            computeAccelerationsAvx2(
+                strength, sourceX, sourceY, sourceMass, sourceCount, targetX, targetY, accX, accY, targetCount);
+            return;
+#endif
+        default:
+            computeAccelerationsScalar(
+                strength, sourceX, sourceY, sourceMass, sourceCount, targetX, targetY, accX, accY, targetCount);
+            return;
+    }
+}
+
+}  // namespace sve
@@ -0,0 +1,39 @@
+#pragma once
+
+// std
+#include <cstddef>
+
+namespace sve {
+
+enum class SimdLevel {
+    Scalar,
+    Avx2,    // 8 targets per instruction
+    Avx512,  // 16 targets per instruction
+};
+
+// highest level supported by both the cpu and the os, queried once through cpuid
+SimdLevel detectSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+// size in bytes of the level 1 data cache of the cpu we are running on, 32KB if it can't be read
+size_t detectL1DataCacheSize();
+
+// Writes the acceleration every source induces on each target into accX/accY:
+//   acc_t = strength * sum_s m_s * (p_s - p_t) / |p_s - p_t|^3
+// Pairs closer than 1e-5 apart contribute nothing, the same cutoff computeForce uses, so a set
+// of bodies can be passed as both sources and targets. Levels the cpu does not support fall back
+// to the next lower one.
+void computeAccelerations(
+    SimdLevel level,
+    float strength,
+    const float *sourceX,
+    const float *sourceY,
+    const float *sourceMass,
+    size_t sourceCount,
+    const float *targetX,
+    const float *targetY,
+    float *accX,
+    float *accY,
+    size_t targetCount);
+
+}  // namespace sve
@@ -0,0 +1,486 @@
+#include "gravity_physics_system.hpp"
+
+#include "sve_profiler.hpp"
+
+// std
+#include <algorithm>
+
+namespace sve {
+
+void GravityPhysicsSystem::update(SveBodyStore& bodies, float dt, unsigned int substeps) {
+    const float stepDelta = dt / substeps;
+    for (unsigned int i = 0; i < substeps; i++) {
+        SVE_PROFILE_SCOPE("substep");
+        stepSimulation(bodies, stepDelta);
+    }
+}
+
+glm::vec2 GravityPhysicsSystem::computeForce(
+    glm::vec2 fromPosition, float fromMass, glm::vec2 toPosition, float toMass) const {
+    auto offset = fromPosition - toPosition;
+    float distanceSquared = glm::dot(offset, offset);
+
+    // clown town - just going to return 0 if objects are too close together...
+    if (glm::abs(distanceSquared) < 1e-10f) {
+        return {.0f, .0f};
+    }
+
+    float force = strengthGravity * toMass * fromMass / distanceSquared;
+    return force * offset / glm::sqrt(distanceSquared);
+}
+
+void GravityPhysicsSystem::stepSimulation(SveBodyStore& bodies, float dt) {
+    switch (integrator) {
+        case Integrator::SemiImplicitEuler:
+            evaluateForces(bodies);
+            kick(bodies, dt);
+            drift(bodies, dt);
+            accelerationsValid = false;
+            break;
+
+        case Integrator::Leapfrog:
+            // the closing kick of a step evaluates forces at the positions the next step starts from,
+            // so after the first step this costs a single force evaluation
+            if (!accelerationsValid || accelerationX.size() != bodies.size()) {
+                evaluateForces(bodies);
+            }
+            kick(bodies, 0.5f * dt);
+            drift(bodies, dt);
+            evaluateForces(bodies);
+            kick(bodies, 0.5f * dt);
+            accelerationsValid = true;
+            break;
+
+        case Integrator::Yoshida4: {
+            // Yoshida's fourth order composition of three leapfrog steps, written as drifts and kicks
+            // with weights w1 = 1 / (2 - 2^(1/3)) and w0 = -2^(1/3) / (2 - 2^(1/3)). The middle kick
+            // goes backwards in time.
+            constexpr double cubeRootTwo = 1.2599210498948732;
+            constexpr float w1 = static_cast<float>(1.0 / (2.0 - cubeRootTwo));
+            constexpr float w0 = static_cast<float>(-cubeRootTwo / (2.0 - cubeRootTwo));
+            constexpr float driftWeights[4] = {0.5f * w1, 0.5f * (w0 + w1), 0.5f * (w0 + w1), 0.5f * w1};
+            constexpr float kickWeights[3] = {w1, w0, w1};
+
+            for (int stage = 0; stage < 3; stage++) {
+                drift(bodies, driftWeights[stage] * dt);
+                evaluateForces(bodies);
+                kick(bodies, kickWeights[stage] * dt);
+            }
+            drift(bodies, driftWeights[3] * dt);
+            accelerationsValid = false;
+            break;
+        }
+
+        case Integrator::BlockTimestep:
+            stepBlockTimesteps(bodies, dt);
+            break;
+    }
+}
+
+void GravityPhysicsSystem::stepBlockTimesteps(SveBodyStore& bodies, float dt) {
+    // Time inside the step is counted in ticks of the finest possible level, a body on level l
+    // finishes a step every tickCount >> l ticks. Every body starts and ends the step in sync.
+    const size_t count = bodies.size();
+    const uint32_t tickCount = 1u << timestepLevelCap();
+    const float tickDelta = dt / tickCount;
+
+    if (!accelerationsValid || accelerationX.size() != count || timestepLevels.size() != count) {
+        evaluateForces(bodies);
+        timestepLevels.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            timestepLevels[i] = chooseTimestepLevel(i, dt);
+        }
+    } else if (solver == ForceSolver::BarnesHut) {
+        tree.build(bodies.positionX.data(), bodies.positionY.data(), bodies.mass.data(), count);
+    }
+
+    // opening half kick for every body, its step starts now
+    uint8_t finestLevel = 0;
+    for (size_t i = 0; i < count; i++) {
+        finestLevel = std::max(finestLevel, timestepLevels[i]);
+        const float bodyDelta = dt / static_cast<float>(1u << timestepLevels[i]);
+        bodies.velocityX[i] += 0.5f * bodyDelta * accelerationX[i];
+        bodies.velocityY[i] += 0.5f * bodyDelta * accelerationY[i];
+    }
+
+    uint32_t tick = 0;
+    while (tick < tickCount) {
+        // jump straight to the next tick where some body finishes its step
+        const uint32_t stride = tickCount >> finestLevel;
+        const uint32_t nextTick = (tick / stride + 1) * stride;
+        drift(bodies, (nextTick - tick) * tickDelta);
+        tick = nextTick;
+
+        activeBodies.clear();
+        for (size_t i = 0; i < count; i++) {
+            if (tick % (tickCount >> timestepLevels[i]) == 0) {
+                activeBodies.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        // everyone moved, but only the bodies finishing a step get new forces
+        if (solver == ForceSolver::BarnesHut) {
+            tree.refit(bodies.positionX.data(), bodies.positionY.data());
+        }
+        evaluateActiveForces(bodies);
+
+        finestLevel = 0;
+        for (uint32_t i : activeBodies) {
+            // closing half kick of the step that just ended
+            const float bodyDelta = dt / static_cast<float>(1u << timestepLevels[i]);
+            bodies.velocityX[i] += 0.5f * bodyDelta * accelerationX[i];
+            bodies.velocityY[i] += 0.5f * bodyDelta * accelerationY[i];
+            if (tick == tickCount) continue;
+
+            // pick the level for the next step, finer is always possible but a coarser step has to
+            // start on one of its own boundaries to stay in sync with the other bodies on it
+            uint8_t level = chooseTimestepLevel(i, dt);
+            while (level < timestepLevels[i] && tick % (tickCount >> level) != 0) {
+                level++;
+            }
+            timestepLevels[i] = level;
+
+            // opening half kick of the next step
+            const float nextDelta = dt / static_cast<float>(1u << level);
+            bodies.velocityX[i] += 0.5f * nextDelta * accelerationX[i];
+            bodies.velocityY[i] += 0.5f * nextDelta * accelerationY[i];
+        }
+        for (size_t i = 0; i < count; i++) {
+            finestLevel = std::max(finestLevel, timestepLevels[i]);
+        }
+    }
+
+    // the step ended for everybody, so all accelerations are current for the next opening kick
+    for (size_t i = 0; i < count; i++) {
+        timestepLevels[i] = chooseTimestepLevel(i, dt);
+    }
+    accelerationsValid = true;
+}
+
+uint8_t GravityPhysicsSystem::chooseTimestepLevel(size_t body, float dt) const {
+    const float acceleration = glm::sqrt(
+        accelerationX[body] * accelerationX[body] + accelerationY[body] * accelerationY[body]);
+    if (acceleration <= 0.f) return 0;
+
+    const float wanted = glm::sqrt(timestepAccuracy / acceleration);
+    if (wanted >= dt) return 0;
+    const int level = static_cast<int>(glm::ceil(glm::log2(dt / wanted)));
+    return static_cast<uint8_t>(glm::clamp(level, 0, static_cast<int>(timestepLevelCap())));
+}
+
+void GravityPhysicsSystem::evaluateForces(SveBodyStore& bodies) {
+    accelerationX.resize(bodies.size());
+    accelerationY.resize(bodies.size());
+
+    switch (solver) {
+        case ForceSolver::DirectSum:
+            evaluateDirectSum(bodies);
+            break;
+        case ForceSolver::DirectSumTiled:
+            evaluateDirectSumTiled(bodies);
+            break;
+        case ForceSolver::DirectSumSimd:
+            evaluateDirectSumSimd(bodies);
+            break;
+        case ForceSolver::BarnesHut:
+            evaluateBarnesHut(bodies);
+            break;
+        case ForceSolver::ParticleMesh:
+            evaluateParticleMesh(bodies);
+            break;
+    }
+}
+
+void GravityPhysicsSystem::kick(SveBodyStore& bodies, float dt) {
+    // update each bodies velocity based on the last evaluated forces
+    float* vx = bodies.velocityX.data();
+    float* vy = bodies.velocityY.data();
+    const float* ax = accelerationX.data();
+    const float* ay = accelerationY.data();
+    threadPool->parallelFor(bodies.size(), 16 * 1024, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i = begin; i < end; i++) {
+            vx[i] += dt * ax[i];
+            vy[i] += dt * ay[i];
+        }
+    });
+}
+
+void GravityPhysicsSystem::drift(SveBodyStore& bodies, float dt) {
+    // update each bodies position based on its final velocity
+    float* px = bodies.positionX.data();
+    float* py = bodies.positionY.data();
+    const float* vx = bodies.velocityX.data();
+    const float* vy = bodies.velocityY.data();
+    threadPool->parallelFor(bodies.size(), 16 * 1024, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i = begin; i < end; i++) {
+            px[i] += dt * vx[i];
+            py[i] += dt * vy[i];
+        }
+    });
+}
+
+void GravityPhysicsSystem::evaluateDirectSum(SveBodyStore& bodies) {
+    const size_t count = bodies.size();
+    const float* px = bodies.positionX.data();
+    const float* py = bodies.positionY.data();
+    const float* mass = bodies.mass.data();
+
+    // Every pair writes to both of its bodies, so rows of the pair loop can't be split across
+    // threads directly. Instead each worker sums forces into its own buffers which are reduced
+    // into the accelerations afterwards.
+    prepareWorkerForces(count);
+    const unsigned int workers = threadPool->size();
+
+    // rows get shorter towards the end, small dynamically scheduled chunks keep the workers balanced
+    const size_t rowGrain = count < PARALLEL_MIN_BODIES ? count : std::max<size_t>(1, count / (workers * 16));
+    threadPool->parallelFor(count, rowGrain, [&](size_t begin, size_t end, unsigned int worker) {
+        float* forceX = workerForces(workerForceX, worker);
+        float* forceY = workerForces(workerForceY, worker);
+
+        // Loops through all pairs of bodies and applies attractive force between them
+        for (size_t a = begin; a < end; a++) {
+            const glm::vec2 positionA{px[a], py[a]};
+            glm::vec2 forceA{};
+            for (size_t b = a + 1; b < count; b++) {
+                auto force = computeForce(positionA, mass[a], {px[b], py[b]}, mass[b]);
+                forceA -= force;
+                forceX[b] += force.x;
+                forceY[b] += force.y;
+            }
+            forceX[a] += forceA.x;
+            forceY[a] += forceA.y;
+        }
+    });
+
+    reduceWorkerForces(bodies);
+}
+
+void GravityPhysicsSystem::evaluateDirectSumTiled(SveBodyStore& bodies) {
+    const size_t count = bodies.size();
+    const float* px = bodies.positionX.data();
+    const float* py = bodies.positionY.data();
+    const float* mass = bodies.mass.data();
+
+    // Same pairs as applyDirectSum, but visited one block of target rows against one block of
+    // source columns at a time. While a row block sweeps a column block, the column positions,
+    // masses and force accumulators stay in L1 instead of being streamed from L2/L3 once per row.
+    prepareWorkerForces(count);
+    const size_t tile = std::max<size_t>(tileSize, 16);
+    const size_t tileCount = (count + tile - 1) / tile;
+
+    const size_t tileGrain = count < PARALLEL_MIN_BODIES ? tileCount : 1;
+    threadPool->parallelFor(tileCount, tileGrain, [&](size_t beginTile, size_t endTile, unsigned int worker) {
+        float* forceX = workerForces(workerForceX, worker);
+        float* forceY = workerForces(workerForceY, worker);
+
+        for (size_t rowTile = beginTile; rowTile < endTile; rowTile++) {
+            const size_t rowBegin = rowTile * tile;
+            const size_t rowEnd = std::min(rowBegin + tile, count);
+
+            for (size_t columnTile = rowTile; columnTile < tileCount; columnTile++) {
+                const size_t columnBegin = columnTile * tile;
+                const size_t columnEnd = std::min(columnBegin + tile, count);
+
+                for (size_t a = rowBegin; a < rowEnd; a++) {
+                    const glm::vec2 positionA{px[a], py[a]};
+                    glm::vec2 forceA{};
+                    for (size_t b = std::max(columnBegin, a + 1); b < columnEnd; b++) {
+                        auto force = computeForce(positionA, mass[a], {px[b], py[b]}, mass[b]);
+                        forceA -= force;
+                        forceX[b] += force.x;
+                        forceY[b] += force.y;
+                    }
+                    forceX[a] += forceA.x;
+                    forceY[a] += forceA.y;
+                }
+            }
+        }
+    });
+
+    reduceWorkerForces(bodies);
+}
+
+void GravityPhysicsSystem::evaluateDirectSumSimd(SveBodyStore& bodies) {
+    // every body is both a source and a target, giving up the pair symmetry of evaluateDirectSum
+    // lets each lane own one target so no two lanes ever write the same acceleration
+    const size_t count = bodies.size();
+
+    // workers take blocks of targets against all sources, multiples of 16 keep the simd lanes full
+    const size_t targetGrain = count < PARALLEL_MIN_BODIES ? count : 256;
+    threadPool->parallelFor(count, targetGrain, [&](size_t begin, size_t end, unsigned int) {
+        computeAccelerations(
+            simdLevel,
+            strengthGravity,
+            bodies.positionX.data(),
+            bodies.positionY.data(),
+            bodies.mass.data(),
+            count,
+            bodies.positionX.data() + begin,
+            bodies.positionY.data() + begin,
+            accelerationX.data() + begin,
+            accelerationY.data() + begin,
+            end - begin);
+    });
+}
+
+void GravityPhysicsSystem::evaluateBarnesHut(SveBodyStore& bodies) {
+    // the tree is rebuilt every substep, bodies move too much between substeps for a refit to
+    // keep the cells tight
+    tree.build(bodies.positionX.data(), bodies.positionY.data(), bodies.mass.data(), bodies.size());
+
+    // walk bodies in morton order so neighbouring walks, and the walks of one worker, touch the
+    // same nodes
+    const size_t walkGrain = tree.bodyCount() < PARALLEL_MIN_BODIES ? tree.bodyCount() : 256;
+    threadPool->parallelFor(tree.bodyCount(), walkGrain, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t k = begin; k < end; k++) {
+            const uint32_t i = tree.sortedIndex(k);
+            const glm::vec2 position = bodies.position(i);
+            const float mass = bodies.mass[i];
+
+            glm::vec2 force{};
+            tree.forEachInteraction(position, openingAngle, [&](glm::vec2 sourcePosition, float sourceMass) {
+                force += computeForce(sourcePosition, sourceMass, position, mass);
+            });
+            accelerationX[i] = force.x / mass;
+            accelerationY[i] = force.y / mass;
+        }
+    });
+}
+
+void GravityPhysicsSystem::evaluateParticleMesh(SveBodyStore& bodies) {
+    particleMesh.solve(
+        *threadPool,
+        strengthGravity,
+        meshSize,
+        bodies.positionX.data(),
+        bodies.positionY.data(),
+        bodies.mass.data(),
+        bodies.size());
+
+    threadPool->parallelFor(bodies.size(), 16 * 1024, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i = begin; i < end; i++) {
+            glm::vec2 acceleration = particleMesh.interpolate(bodies.position(i));
+            accelerationX[i] = acceleration.x;
+            accelerationY[i] = acceleration.y;
+        }
+    });
+}
+
+void GravityPhysicsSystem::evaluateActiveForces(SveBodyStore& bodies) {
+    const size_t activeCount = activeBodies.size();
+    if (activeCount == 0) return;
+
+    if (solver == ForceSolver::BarnesHut) {
+        const size_t walkGrain = activeCount < PARALLEL_MIN_BODIES ? activeCount : 256;
+        threadPool->parallelFor(activeCount, walkGrain, [&](size_t begin, size_t end, unsigned int) {
+            for (size_t k = begin; k < end; k++) {
+                const uint32_t i = activeBodies[k];
+                const glm::vec2 position = bodies.position(i);
+                const float mass = bodies.mass[i];
+
+                glm::vec2 force{};
+                tree.forEachInteraction(position, openingAngle, [&](glm::vec2 sourcePosition, float sourceMass) {
+                    force += computeForce(sourcePosition, sourceMass, position, mass);
+                });
+                accelerationX[i] = force.x / mass;
+                accelerationY[i] = force.y / mass;
+            }
+        });
+        return;
+    }
+
+    if (solver == ForceSolver::ParticleMesh) {
+        // the grid solve costs the same whatever the number of targets, only the interpolation is
+        // limited to the active bodies
+        particleMesh.solve(
+            *threadPool,
+            strengthGravity,
+            meshSize,
+            bodies.positionX.data(),
+            bodies.positionY.data(),
+            bodies.mass.data(),
+            bodies.size());
+        for (uint32_t i : activeBodies) {
+            glm::vec2 acceleration = particleMesh.interpolate(bodies.position(i));
+            accelerationX[i] = acceleration.x;
+            accelerationY[i] = acceleration.y;
+        }
+        return;
+    }
+
+    // The pair loops only pay off when every body is a target, a subset goes through the simd
+    // kernel instead. Active bodies are gathered so the kernel sees contiguous targets.
+    activeX.resize(activeCount);
+    activeY.resize(activeCount);
+    activeAccelerationX.resize(activeCount);
+    activeAccelerationY.resize(activeCount);
+    for (size_t k = 0; k < activeCount; k++) {
+        activeX[k] = bodies.positionX[activeBodies[k]];
+        activeY[k] = bodies.positionY[activeBodies[k]];
+    }
+
+    const size_t targetGrain = activeCount < PARALLEL_MIN_BODIES ? activeCount : 256;
+    threadPool->parallelFor(activeCount, targetGrain, [&](size_t begin, size_t end, unsigned int) {
+        computeAccelerations(
+            simdLevel,
+            strengthGravity,
+            bodies.positionX.data(),
+            bodies.positionY.data(),
+            bodies.mass.data(),
+            bodies.size(),
+            activeX.data() + begin,
+            activeY.data() + begin,
+            activeAccelerationX.data() + begin,
+            activeAccelerationY.data() + begin,
+            end - begin);
+
+        for (size_t k = begin; k < end; k++) {
+            accelerationX[activeBodies[k]] = activeAccelerationX[k];
+            accelerationY[activeBodies[k]] = activeAccelerationY[k];
+        }
+    });
+}
+
+void GravityPhysicsSystem::prepareWorkerForces(size_t count) {
+    // buffers are zero between steps, reduceWorkerForces clears them as it goes
+    const unsigned int workers = threadPool->size();
+    const size_t lines = (count + 15) / 16;
+    if (linesPerWorker != lines || workerForceX.size() != workers * lines) {
+        linesPerWorker = lines;
+        workerForceX.assign(workers * lines, CacheLine{});
+        workerForceY.assign(workers * lines, CacheLine{});
+    }
+}
+
+void GravityPhysicsSystem::reduceWorkerForces(SveBodyStore& bodies) {
+    const size_t count = bodies.size();
+    const unsigned int workers = threadPool->size();
+    const float* mass = bodies.mass.data();
+    float* ax = accelerationX.data();
+    float* ay = accelerationY.data();
+
+    // every worker reduces a range of bodies across all buffers, ranges are whole cache lines
+    const size_t reduceGrain = count < PARALLEL_MIN_BODIES ? count : 4096;
+    threadPool->parallelFor(count, reduceGrain, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i = begin; i < end; i++) {
+            ax[i] = 0.f;
+            ay[i] = 0.f;
+        }
+        for (unsigned int w = 0; w < workers; w++) {
+            float* forceX = workerForces(workerForceX, w);
+            float* forceY = workerForces(workerForceY, w);
+            for (size_t i = begin; i < end; i++) {
+                ax[i] += forceX[i];
+                ay[i] += forceY[i];
+                forceX[i] = 0.f;
+                forceY[i] = 0.f;
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            ax[i] /= mass[i];
+            ay[i] /= mass[i];
+        }
+    });
+}
+
+}  // namespace sve
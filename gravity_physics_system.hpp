@@ -0,0 +1,141 @@
+#pragma once
+
+#include "barnes_hut_tree.hpp"
+#include "gravity_kernels.hpp"
+#include "particle_mesh.hpp"
+#include "sve_body_store.hpp"
+#include "sve_thread_pool.hpp"
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sve {
+
+enum class ForceSolver {
+    DirectSum,       // exact O(N^2) pair loop
+    DirectSumTiled,  // exact O(N^2) pair loop over blocks of tileSize bodies that stay in L1
+    DirectSumSimd,   // exact O(N^2) sum, vectorized over targets at simdLevel
+    BarnesHut,       // O(N log N) quadtree approximation, accuracy controlled by openingAngle
+    ParticleMesh,    // O(N + G log G) fft solve on a meshSize^2 grid, smooths out forces below a cell
+};
+
+enum class Integrator {
+    SemiImplicitEuler,  // kick then drift, first order, one force evaluation per step
+    Leapfrog,           // kick-drift-kick, second order and symplectic, one force evaluation per step
+    Yoshida4,           // three leapfrog stages, fourth order and symplectic, three force evaluations per step
+    BlockTimestep,      // leapfrog where every body advances on its own power of two fraction of the step
+};
+
+class GravityPhysicsSystem {
+   public:
+    // threadCount is the size of the worker pool used by the force passes, 0 uses every hardware thread
+    GravityPhysicsSystem(float strength, unsigned int threadCount = 0)
+        : strengthGravity{strength}, threadPool{std::make_unique<SveThreadPool>(threadCount)} {}
+
+    const float strengthGravity;
+
+    ForceSolver solver{ForceSolver::DirectSum};
+    Integrator integrator{Integrator::SemiImplicitEuler};
+
+    // Barnes-Hut opening angle (theta). Groups of bodies are treated as a single mass once
+    // cellSize / distance drops below it, so 0 is exact and larger values trade accuracy for speed
+    float openingAngle{0.5f};
+
+    // grid points per axis for ParticleMesh, a power of two. The grid is fitted around the bodies
+    // every evaluation so this sets the smallest scale forces are resolved at
+    unsigned int meshSize{256};
+
+    // BlockTimestep settings. A body with acceleration a wants a step of sqrt(timestepAccuracy / |a|)
+    // and gets the largest dt / 2^level below that, with level capped at maxTimestepLevel. Levels
+    // above MAX_TIMESTEP_LEVEL are treated as it, a step is split into at most 2^16 ticks
+    static constexpr unsigned int MAX_TIMESTEP_LEVEL = 16;
+    float timestepAccuracy{0.001f};
+    unsigned int maxTimestepLevel{6};
+
+    // instruction set used by DirectSumSimd and the field system, lower it to compare against the
+    // scalar fallback
+    SimdLevel simdLevel{detectSimdLevel()};
+
+    // bodies per block in DirectSumTiled, sized from the L1 data cache of the machine we start on
+    size_t tileSize{chooseTileSize(detectL1DataCacheSize())};
+
+    // two tiles of positions, masses and force accumulators, 5 floats per body, filling half of l1
+    // so the rest of the working set still has room
+    static size_t chooseTileSize(size_t l1CacheSize) {
+        size_t bodies = l1CacheSize / 2 / (2 * 5 * sizeof(float));
+        return std::max<size_t>(16, bodies / 16 * 16);
+    }
+
+    // dt stands for delta time, and specifies the amount of time to advance the simulation
+    // substeps is how many intervals to divide the forward time step in. More substeps result in a
+    // more stable simulation, but takes longer to compute
+    void update(SveBodyStore &bodies, float dt, unsigned int substeps = 1);
+
+    glm::vec2 computeForce(glm::vec2 fromPosition, float fromMass, glm::vec2 toPosition, float toMass) const;
+
+    // Leapfrog reuses the forces from the end of the previous step, call this after moving or
+    // adding bodies outside of update() so they get evaluated again
+    void invalidateForces() { accelerationsValid = false; }
+
+    // shared with the field system so both run on the same workers
+    SveThreadPool &getThreadPool() const { return *threadPool; }
+
+   private:
+    // below this many bodies a pass runs on the calling thread, waking the pool costs more than it saves
+    static constexpr size_t PARALLEL_MIN_BODIES = 512;
+
+    // one cache line worth of floats, vectors of these are 64 byte aligned since c++17
+    struct alignas(64) CacheLine {
+        float values[16];
+    };
+
+    void stepSimulation(SveBodyStore &bodies, float dt);
+    void kick(SveBodyStore &bodies, float dt);
+    void drift(SveBodyStore &bodies, float dt);
+    void stepBlockTimesteps(SveBodyStore &bodies, float dt);
+    uint8_t chooseTimestepLevel(size_t body, float dt) const;
+    unsigned int timestepLevelCap() const { return std::min(maxTimestepLevel, MAX_TIMESTEP_LEVEL); }
+
+    // fills accelerationX/Y for the current positions with the selected solver
+    void evaluateForces(SveBodyStore &bodies);
+    void evaluateDirectSum(SveBodyStore &bodies);
+    void evaluateDirectSumTiled(SveBodyStore &bodies);
+    void evaluateDirectSumSimd(SveBodyStore &bodies);
+    void evaluateBarnesHut(SveBodyStore &bodies);
+    void evaluateParticleMesh(SveBodyStore &bodies);
+
+    // only refreshes accelerationX/Y of the bodies in activeBodies, the tree has to be current
+    void evaluateActiveForces(SveBodyStore &bodies);
+
+    void prepareWorkerForces(size_t count);
+    void reduceWorkerForces(SveBodyStore &bodies);
+    float *workerForces(std::vector<CacheLine> &buffer, unsigned int worker) {
+        return buffer[worker * linesPerWorker].values;
+    }
+
+    std::unique_ptr<SveThreadPool> threadPool;
+    BarnesHutTree tree;
+    ParticleMesh particleMesh;
+
+    // per worker force accumulators for the pair loops, each worker's slice starts on its own cache line
+    std::vector<CacheLine> workerForceX;
+    std::vector<CacheLine> workerForceY;
+    size_t linesPerWorker{0};
+
+    std::vector<float> accelerationX;
+    std::vector<float> accelerationY;
+    bool accelerationsValid{false};
+
+    // block timestep state, level per body and the bodies finishing a step at the current sub tick
+    std::vector<uint8_t> timestepLevels;
+    std::vector<uint32_t> activeBodies;
+    std::vector<float> activeX;
+    std::vector<float> activeY;
+    std::vector<float> activeAccelerationX;
+    std::vector<float> activeAccelerationY;
+};
+
+}  // namespace sve
@@ -0,0 +1,129 @@
+#include "headless_app.hpp"
+
+#include "gpu_gravity_system.hpp"
+#include "sve_device.hpp"
+#include "sve_snapshot.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+namespace sve {
+
+// above this many bodies the exact pair loop stops being worth it for a batch run
+static constexpr size_t BARNES_HUT_MIN_BODIES = 4096;
+
+// without a scenario file: bodies at rest spread over the same square the window shows, total mass
+// of one so the collapse takes about as long whatever the count
+static Scenario loadScenario(const HeadlessOptions &options) {
+    if (!options.scenarioPath.empty()) {
+        return Scenario::load(options.scenarioPath);
+    }
+
+    Scenario scenario{};
+    scenario.solver = options.bodyCount >= BARNES_HUT_MIN_BODIES ? ForceSolver::BarnesHut : ForceSolver::DirectSumSimd;
+    BodySetDescription cloud{};
+    cloud.kind = BodySetKind::Uniform;
+    cloud.count = options.bodyCount;
+    cloud.seed = 1234;
+    scenario.bodySets.push_back(cloud);
+    return scenario;
+}
+
+// gpu ticks submitted per command buffer, keeps a single submission well clear of driver timeouts
+static constexpr unsigned int GPU_TICKS_PER_SUBMIT = 60;
+
+HeadlessApp::HeadlessApp(HeadlessOptions options)
+    : options{std::move(options)},
+      scenario{loadScenario(this->options)},
+      gravitySystem{scenario.strength, scenario.threadCount} {
+    scenario.configure(gravitySystem);
+    if (!this->options.inputPath.empty()) {
+        simulationTime = readSnapshot(this->options.inputPath, bodies);
+    } else {
+        scenario.generateBodies(gravitySystem.getThreadPool(), bodies);
+    }
+
+    if (!this->options.recordPath.empty()) {
+        trajectoryWriter = std::make_unique<SveTrajectoryWriter>(this->options.recordPath);
+    }
+
+    scenario.createFieldSamples(fieldSamples);
+}
+
+void HeadlessApp::run() {
+    double seconds = options.gpuPhysics ? runGpu() : runCpu();
+    simulationTime += static_cast<double>(options.steps) * scenario.tickDelta;
+
+    std::printf(
+        "%zu bodies, %u steps in %.3f s, %.1f steps/s\n",
+        bodies.size(),
+        options.steps,
+        seconds,
+        seconds > 0.0 ? options.steps / seconds : 0.0);
+
+    if (trajectoryWriter) {
+        uint64_t dropped = trajectoryWriter->getDroppedFrames();
+        trajectoryWriter.reset();  // waits for the queued frames to be written
+        std::printf("trajectory written to %s, %llu frames dropped\n", options.recordPath.c_str(),
+                    static_cast<unsigned long long>(dropped));
+    }
+
+    writeSnapshot(options.outputPath, bodies, simulationTime);
+}
+
+double HeadlessApp::runCpu() {
+    Vec2FieldSystem vecFieldSystem{};
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int step = 0; step < options.steps; step++) {
+        gravitySystem.update(bodies, scenario.tickDelta, scenario.substeps);
+        vecFieldSystem.update(gravitySystem, bodies, fieldSamples);
+        recordStep(step + 1);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+double HeadlessApp::runGpu() {
+    // the cpu system only lends its constants and workers to the field pass at the end
+    Vec2FieldSystem vecFieldSystem{};
+
+    // the compute shader only does semi-implicit euler
+    if (scenario.integrator != Integrator::SemiImplicitEuler) {
+        std::fprintf(stderr, "warning: the gpu integrates with semi-implicit euler, ignoring the scenario's integrator\n");
+    }
+
+    SveDevice device{};
+    GpuGravitySystem gpuGravitySystem{device, gravitySystem.strengthGravity, bodies};
+
+    // recorded steps have to come back to the cpu, so a submission never runs past the next one
+    const unsigned int interval = std::max(1u, options.recordInterval);
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int step = 0; step < options.steps;) {
+        unsigned int ticks = std::min(GPU_TICKS_PER_SUBMIT, options.steps - step);
+        if (trajectoryWriter) ticks = std::min(ticks, interval - step % interval);
+        gpuGravitySystem.update(scenario.tickDelta / scenario.substeps, ticks * scenario.substeps);
+        step += ticks;
+        if (trajectoryWriter && step % interval == 0) {
+            gpuGravitySystem.readBack(bodies);
+            recordStep(step);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    gpuGravitySystem.readBack(bodies);
+    vecFieldSystem.update(gravitySystem, bodies, fieldSamples);
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void HeadlessApp::recordStep(unsigned int step) {
+    if (!trajectoryWriter || step % std::max(1u, options.recordInterval) != 0) return;
+    trajectoryWriter->record(bodies, step, simulationTime + static_cast<double>(step) * scenario.tickDelta);
+}
+
+}  // namespace sve
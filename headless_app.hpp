@@ -0,0 +1,57 @@
+#pragma once
+
+#include "gravity_physics_system.hpp"
+#include "sve_body_store.hpp"
+#include "sve_scenario.hpp"
+#include "sve_trajectory_writer.hpp"
+#include "vec2_field_system.hpp"
+
+// std
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace sve {
+
+struct HeadlessOptions {
+    size_t bodyCount{1000};  // size of the random cloud used when there is no scenarioPath
+    unsigned int steps{600};
+    std::string scenarioPath{};  // bodies, field and physics settings
+    std::string inputPath{};     // snapshot to resume from, replaces the scenario's bodies
+    std::string outputPath{"bodies.snap"};
+    bool gpuPhysics{false};  // run gravity in the compute shader, the only case vulkan is started
+
+    // trajectory file that every recordInterval-th step is written to, none when empty
+    std::string recordPath{};
+    unsigned int recordInterval{1};
+};
+
+// Runs the simulation without a window or swapchain, for machines with no display. Steps as fast as
+// the cpu (or gpu) allows, reports steps per second and writes a snapshot of the final bodies to
+// outputPath, which can be passed back in as inputPath to carry on.
+class HeadlessApp {
+   public:
+    explicit HeadlessApp(HeadlessOptions options);
+
+    HeadlessApp(const HeadlessApp &) = delete;
+    HeadlessApp &operator=(const HeadlessApp &) = delete;
+
+    void run();
+
+   private:
+    // returns the wall time in seconds spent stepping
+    double runCpu();
+    double runGpu();
+    void recordStep(unsigned int step);
+
+    const HeadlessOptions options;
+    const Scenario scenario;
+    GravityPhysicsSystem gravitySystem;
+
+    SveBodyStore bodies;
+    double simulationTime{0.0};
+    Vec2FieldSamples fieldSamples;
+    std::unique_ptr<SveTrajectoryWriter> trajectoryWriter;
+};
+
+}  // namespace sve
@@ -1,19 +1,83 @@
 #include "first_app.hpp"
+#include "headless_app.hpp"
+#include "sve_profiler.hpp"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main() {
-    sve::FirstApp app{};
+static const char *USAGE =
+    " [--gpu] [--parallel-draw] [--scenario <file>] [--load <snapshot>] [--record <trajectory> <every>]"
+    " [--trace <json> <seconds>] [--headless <bodies> <steps> <output>]";
+
+// --load replaces the scenario's bodies with a snapshot to carry on from. The headless body count
+// only sizes the random cloud used without a scenario. --record only applies to headless runs,
+// --trace only to windowed ones in builds without NDEBUG. --parallel-draw only changes how a
+// windowed run draws cpu simulated bodies
+int main(int argc, char **argv) {
+    bool gpuPhysics = false;
+    bool parallelDraw = false;
+    bool headless = false;
+    std::string scenarioPath{};
+    std::string statePath{};
+    std::string tracePath{};
+    double traceSeconds = 0.0;
+    sve::HeadlessOptions headlessOptions{};
+    for (int i = 1; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == "--gpu") {
+            gpuPhysics = true;
+        } else if (arg == "--parallel-draw") {
+            parallelDraw = true;
+        } else if (arg == "--scenario" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "--load" && i + 1 < argc) {
+            statePath = argv[++i];
+        } else if (arg == "--record" && i + 2 < argc) {
+            headlessOptions.recordPath = argv[i + 1];
+            headlessOptions.recordInterval = static_cast<unsigned int>(std::strtoul(argv[i + 2], nullptr, 10));
+            i += 2;
+        } else if (arg == "--trace" && i + 2 < argc) {
+            tracePath = argv[i + 1];
+            traceSeconds = std::strtod(argv[i + 2], nullptr);
+            i += 2;
+        } else if (arg == "--headless" && i + 3 < argc) {
+            headless = true;
+            headlessOptions.bodyCount = std::strtoull(argv[i + 1], nullptr, 10);
+            headlessOptions.steps = static_cast<unsigned int>(std::strtoul(argv[i + 2], nullptr, 10));
+            headlessOptions.outputPath = argv[i + 3];
+            i += 3;
+        } else {
+            std::cerr << "usage: " << argv[0] << USAGE << '\n';
+            return EXIT_FAILURE;
+        }
+    }
 
     try {
-        app.run();
+        // the windowed app brings up glfw and vulkan as soon as it is constructed, so only build
+        // the one that is going to run
+        if (headless) {
+            headlessOptions.gpuPhysics = gpuPhysics;
+            headlessOptions.scenarioPath = scenarioPath;
+            headlessOptions.inputPath = statePath;
+            sve::HeadlessApp app{headlessOptions};
+            app.run();
+        } else {
+            sve::FirstApp app{
+                scenarioPath.empty() ? sve::FirstApp::DEFAULT_SCENARIO : scenarioPath, statePath, gpuPhysics, parallelDraw};
+            if (!tracePath.empty()) {
+                if (!SVE_PROFILE_ENABLED) throw std::runtime_error("--trace needs a build without NDEBUG");
+                sve::SveProfiler::get().startTrace(tracePath, traceSeconds);
+            }
+            app.run();
+            if (SVE_PROFILE_ENABLED) sve::SveProfiler::get().stopTrace();
+        }
     } catch (const std::exception &e) {
         std::cerr << e.what() << '\n';
         return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,163 @@
+#include "particle_mesh.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace sve {
+
+// bodies deposited per chunk, and grid rows or columns transformed per chunk
+static constexpr size_t DEPOSIT_GRAIN = 4096;
+static constexpr size_t LINE_GRAIN = 8;
+
+void ParticleMesh::solve(
+    SveThreadPool &threadPool,
+    float strength,
+    unsigned int size,
+    const float *positionX,
+    const float *positionY,
+    const float *masses,
+    size_t count) {
+    assert(size >= 8 && (size & (size - 1)) == 0 && "mesh size has to be a power of two of at least 8");
+    if (size != meshSize) {
+        meshSize = size;
+        paddedSize = 2 * static_cast<size_t>(size);
+        fft.resize(paddedSize);
+        prepareGreensFunction();
+        grid.assign(paddedSize * paddedSize, {});
+        gridAcceleration.assign(static_cast<size_t>(size) * size, {});
+        workerMass.clear();
+    }
+    if (workerMass.size() != threadPool.size()) {
+        workerMass.assign(threadPool.size(), std::vector<float>(static_cast<size_t>(meshSize) * meshSize, 0.f));
+        workerColumns.assign(threadPool.size(), std::vector<std::complex<float>>(paddedSize));
+    }
+    if (count == 0) {
+        std::fill(gridAcceleration.begin(), gridAcceleration.end(), glm::vec2{});
+        return;
+    }
+
+    // fit the grid around the bodies with one empty grid point on every side, so the cloud in cell
+    // stencil of every body lands inside
+    glm::vec2 lo{positionX[0], positionY[0]};
+    glm::vec2 hi = lo;
+    for (size_t i = 1; i < count; i++) {
+        lo = glm::min(lo, glm::vec2{positionX[i], positionY[i]});
+        hi = glm::max(hi, glm::vec2{positionX[i], positionY[i]});
+    }
+    float extent = glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), 1e-6f);
+    cellSize = extent / (meshSize - 3);
+    inverseCellSize = 1.f / cellSize;
+    origin = lo - glm::vec2{cellSize};
+
+    // cloud in cell deposit, every worker into its own grid so no atomics are needed
+    threadPool.parallelFor(count, DEPOSIT_GRAIN, [&](size_t begin, size_t end, unsigned int worker) {
+        float *mass = workerMass[worker].data();
+        for (size_t i = begin; i < end; i++) {
+            float weightX, weightY;
+            size_t cell = cellOf({positionX[i], positionY[i]}, weightX, weightY);
+            mass[cell] += (1.f - weightX) * (1.f - weightY) * masses[i];
+            mass[cell + 1] += weightX * (1.f - weightY) * masses[i];
+            mass[cell + meshSize] += (1.f - weightX) * weightY * masses[i];
+            mass[cell + meshSize + 1] += weightX * weightY * masses[i];
+        }
+    });
+
+    // Sum the worker grids into the lower left quarter of the padded grid and transform those rows.
+    // The upper half is all padding, its rows stay zero and need no transform.
+    threadPool.parallelFor(meshSize, LINE_GRAIN, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t y = begin; y < end; y++) {
+            std::complex<float> *row = &grid[y * paddedSize];
+            std::fill(row, row + paddedSize, std::complex<float>{});
+            for (auto &mass : workerMass) {
+                float *massRow = &mass[y * meshSize];
+                for (size_t x = 0; x < meshSize; x++) {
+                    row[x] += massRow[x];
+                    massRow[x] = 0.f;
+                }
+            }
+            fft.forward(row);
+        }
+    });
+    threadPool.parallelFor(paddedSize - meshSize, LINE_GRAIN, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t y = meshSize + begin; y < meshSize + end; y++) {
+            std::fill(&grid[y * paddedSize], &grid[y * paddedSize] + paddedSize, std::complex<float>{});
+        }
+    });
+
+    // columns go forward, get multiplied with the green's function and go back in one pass, so each
+    // column is only gathered into contiguous scratch once
+    threadPool.parallelFor(paddedSize, LINE_GRAIN, [&](size_t begin, size_t end, unsigned int worker) {
+        std::complex<float> *column = workerColumns[worker].data();
+        for (size_t x = begin; x < end; x++) {
+            for (size_t y = 0; y < paddedSize; y++) {
+                column[y] = grid[y * paddedSize + x];
+            }
+            fft.forward(column);
+            for (size_t y = 0; y < paddedSize; y++) {
+                column[y] *= greens[y * paddedSize + x];
+            }
+            fft.inverse(column);
+            for (size_t y = 0; y < paddedSize; y++) {
+                grid[y * paddedSize + x] = column[y];
+            }
+        }
+    });
+
+    // Back along the rows, only for the rows the gradient reads. The convolution is circular over
+    // the padded grid, so row and column -1 (the last ones) and meshSize hold the correct potential
+    // just outside of the mesh.
+    threadPool.parallelFor(meshSize + 2, LINE_GRAIN, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t k = begin; k < end; k++) {
+            size_t y = k <= meshSize ? k : paddedSize - 1;
+            fft.inverse(&grid[y * paddedSize]);
+        }
+    });
+
+    // grid holds sum(m * -1/r) in cell units, times paddedSize^2 from the unscaled inverse transform.
+    // a = -grad(phi) with phi = strength * grid / (cellSize * paddedSize^2), central differences
+    const float scale = strength / (2.f * cellSize * cellSize * static_cast<float>(paddedSize * paddedSize));
+    threadPool.parallelFor(meshSize, LINE_GRAIN, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t y = begin; y < end; y++) {
+            const size_t below = (y + paddedSize - 1) % paddedSize;
+            for (size_t x = 0; x < meshSize; x++) {
+                const size_t left = (x + paddedSize - 1) % paddedSize;
+                float dx = grid[y * paddedSize + x + 1].real() - grid[y * paddedSize + left].real();
+                float dy = grid[(y + 1) * paddedSize + x].real() - grid[below * paddedSize + x].real();
+                gridAcceleration[y * meshSize + x] = -scale * glm::vec2{dx, dy};
+            }
+        }
+    });
+}
+
+void ParticleMesh::prepareGreensFunction() {
+    // -1/r between grid points, distances wrap around the padded grid. The point itself gets the
+    // average of -1/r over a unit cell, 4 ln(1 + sqrt(2))
+    std::vector<std::complex<float>> samples(paddedSize * paddedSize);
+    for (size_t y = 0; y < paddedSize; y++) {
+        for (size_t x = 0; x < paddedSize; x++) {
+            float dx = static_cast<float>(std::min(x, paddedSize - x));
+            float dy = static_cast<float>(std::min(y, paddedSize - y));
+            float distance = std::sqrt(dx * dx + dy * dy);
+            samples[y * paddedSize + x] = distance > 0.f ? -1.f / distance : -3.5254940f;
+        }
+    }
+
+    std::vector<std::complex<float>> column(paddedSize);
+    for (size_t y = 0; y < paddedSize; y++) {
+        fft.forward(&samples[y * paddedSize]);
+    }
+    greens.resize(paddedSize * paddedSize);
+    for (size_t x = 0; x < paddedSize; x++) {
+        for (size_t y = 0; y < paddedSize; y++) {
+            column[y] = samples[y * paddedSize + x];
+        }
+        fft.forward(column.data());
+        for (size_t y = 0; y < paddedSize; y++) {
+            greens[y * paddedSize + x] = column[y].real();
+        }
+    }
+}
+
+}  // namespace sve
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "fft.hpp"
+#include "sve_thread_pool.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace sve {
+
+// Particle-mesh gravity. Masses are spread onto a square grid fitted around the bodies with cloud in
+// cell weights, the potential comes from convolving that grid with -1/r through an fft, and the
+// acceleration at each grid point is its finite difference gradient. The grid is zero padded to
+// twice its size so bodies only see each other and not periodic images. Costs O(N + G log G) but
+// forces are smoothed out below the size of a cell, so it suits large smooth distributions rather
+// than close encounters.
+class ParticleMesh {
+   public:
+    // Deposits the bodies onto a meshSize x meshSize grid and solves for the acceleration on every
+    // grid point. meshSize has to be a power of two and at least 8.
+    void solve(
+        SveThreadPool &threadPool,
+        float strength,
+        unsigned int meshSize,
+        const float *positionX,
+        const float *positionY,
+        const float *masses,
+        size_t count);
+
+    // acceleration at position from the last solve, interpolated back with the same cloud in cell
+    // weights the deposit used
+    glm::vec2 interpolate(glm::vec2 position) const {
+        float weightX, weightY;
+        size_t cell = cellOf(position, weightX, weightY);
+        return (1.f - weightY) * ((1.f - weightX) * gridAcceleration[cell] + weightX * gridAcceleration[cell + 1]) +
+               weightY * ((1.f - weightX) * gridAcceleration[cell + meshSize] +
+                          weightX * gridAcceleration[cell + meshSize + 1]);
+    }
+
+    float getCellSize() const { return cellSize; }
+
+   private:
+    // index of the lower left of the 4 grid points around position, and the weights of the upper ones
+    size_t cellOf(glm::vec2 position, float &weightX, float &weightY) const {
+        glm::vec2 u = (position - origin) * inverseCellSize;
+        int x = glm::clamp(static_cast<int>(u.x), 0, static_cast<int>(meshSize) - 2);
+        int y = glm::clamp(static_cast<int>(u.y), 0, static_cast<int>(meshSize) - 2);
+        weightX = glm::clamp(u.x - x, 0.f, 1.f);
+        weightY = glm::clamp(u.y - y, 0.f, 1.f);
+        return static_cast<size_t>(y) * meshSize + x;
+    }
+
+    void prepareGreensFunction();
+
+    unsigned int meshSize{0};
+    size_t paddedSize{0};  // 2 * meshSize, rows and columns of the fft grid
+    glm::vec2 origin{};    // position of grid point 0, 0
+    float cellSize{1.f};
+    float inverseCellSize{1.f};
+
+    Fft fft;
+
+    // transform of -1/r sampled in units of cells, it is real and even so its transform is real too.
+    // Only depends on the grid size, the cell size is applied as a scale
+    std::vector<float> greens;
+
+    std::vector<std::complex<float>> grid;              // paddedSize x paddedSize, rows along x
+    std::vector<std::vector<float>> workerMass;         // per worker deposit, meshSize x meshSize
+    std::vector<std::vector<std::complex<float>>> workerColumns;  // column scratch
+    std::vector<glm::vec2> gridAcceleration;            // meshSize x meshSize
+};
+
+}  // namespace sve
@@ -0,0 +1,18 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+// per instance, read straight from the gravity compute buffer
+layout(location = 2) in vec2 bodyPosition;
+
+// same block as simple_shader so the fragment shader is shared
+layout(push_constant) uniform Push {
+    mat2 transform;
+    vec2 offset;
+    vec3 color;
+} push;
+
+void main() {
+    gl_Position = vec4(push.transform * position + push.offset + bodyPosition, 0.0, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+// per instance, written by SimpleRenderSystem::renderGameObjectsInstanced
+layout(location = 2) in vec2 instanceOffset;
+layout(location = 3) in vec2 instanceScale;
+layout(location = 4) in float instanceRotation;
+layout(location = 5) in vec4 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // same as Transform2dComponent::mat2, done here so the cpu only copies
+    float s = sin(instanceRotation);
+    float c = cos(instanceRotation);
+    mat2 transform = mat2(c, s, -s, c) * mat2(instanceScale.x, 0.0, 0.0, instanceScale.y);
+    gl_Position = vec4(transform * position + instanceOffset, 0.0, 1.0);
+    fragColor = instanceColor.rgb;
+}
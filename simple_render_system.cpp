@@ -1,4 +1,7 @@
 #include "simple_render_system.hpp"
+
+#include "sve_profiler.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -6,6 +9,7 @@
 #include <glm/gtc/constants.hpp>  // for PI
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
@@ -18,12 +22,41 @@ struct SimplePushConstantData {
     alignas(16) glm::vec3 color;
 };
 
+// positions in shaders/cull.comp are words into the frame's part of the frame ring
+struct CullPushConstantData {
+    glm::vec2 viewMin;
+    glm::vec2 viewMax;
+    uint32_t instanceCount;
+    uint32_t inputWord;
+    uint32_t outputWord;
+    uint32_t commandWord;
+    float radius;
+};
+
+static uint32_t packUnorm8(float value) { return static_cast<uint32_t>(glm::clamp(value, 0.f, 1.f) * 255.f + 0.5f); }
+
+static uint32_t packColor(glm::vec3 color) {
+    return packUnorm8(color.x) | packUnorm8(color.y) << 8 | packUnorm8(color.z) << 16 | 0xff000000u;
+}
+
 SimpleRenderSystem::SimpleRenderSystem(SveDevice& device, VkRenderPass renderPass) : sveDevice{device} {
     createPipelineLayout();
     createPipeline(renderPass);
+    createInstancedPipeline(renderPass);
+    createCullPipeline();
 }
 
-SimpleRenderSystem::~SimpleRenderSystem() { vkDestroyPipelineLayout(sveDevice.device(), pipelineLayout, nullptr); }
+SimpleRenderSystem::~SimpleRenderSystem() {
+    for (auto& list : staticDrawLists) {
+        for (auto& frame : list.frames) {
+            destroyStaticFrame(frame);
+        }
+    }
+    vkDestroyPipelineLayout(sveDevice.device(), cullPipelineLayout, nullptr);
+    vkDestroyDescriptorPool(sveDevice.device(), cullDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(sveDevice.device(), cullSetLayout, nullptr);
+    vkDestroyPipelineLayout(sveDevice.device(), pipelineLayout, nullptr);
+}
 
 void SimpleRenderSystem::createPipelineLayout() {
     // push constant
@@ -58,10 +91,352 @@ void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
         pipelineConfig);
 }
 
+void SimpleRenderSystem::createInstancedPipeline(VkRenderPass renderPass) {
+    PipelineConfigInfo pipelineConfig{};
+    SvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+
+    // binding 1 steps once per instance through the frame's instance buffer
+    pipelineConfig.bindingDescriptions.push_back({1, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE});
+    pipelineConfig.attributeDescriptions.push_back({2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(InstanceData, offset)});
+    pipelineConfig.attributeDescriptions.push_back({3, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(InstanceData, scale)});
+    pipelineConfig.attributeDescriptions.push_back({4, 1, VK_FORMAT_R32_SFLOAT, offsetof(InstanceData, rotation)});
+    pipelineConfig.attributeDescriptions.push_back({5, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(InstanceData, color)});
+
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+    instancedPipeline = std::make_unique<SvePipeline>(
+        sveDevice,
+        "shaders/simple_instanced.vert.spv",
+        "shaders/simple_instanced.frag.spv",
+        pipelineConfig);
+}
+
+void SimpleRenderSystem::createCullPipeline() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(sveDevice.device(), &layoutInfo, nullptr, &cullSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(sveDevice.device(), &poolInfo, nullptr, &cullDescriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = cullDescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &cullSetLayout;
+    if (vkAllocateDescriptorSets(sveDevice.device(), &allocInfo, &cullDescriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.size = sizeof(CullPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &cullSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(sveDevice.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    cullPipeline = std::make_unique<SveComputePipeline>(sveDevice, "shaders/cull.comp.spv", cullPipelineLayout);
+}
+
+void SimpleRenderSystem::updateCullDescriptorSet(const SveFrameRingBuffer& frameRing) {
+    // The ring only replaces its buffer from beginFrame after the device went idle, so no submitted
+    // work still uses the set. It also always grows, a new buffer never looks like the old one
+    if (frameRing.getBuffer() == cullSetBuffer && frameRing.getBytesPerFrame() == cullSetRange) return;
+    cullSetBuffer = frameRing.getBuffer();
+    cullSetRange = frameRing.getBytesPerFrame();
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = cullSetBuffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = cullSetRange;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = cullDescriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(sveDevice.device(), 1, &write, 0, nullptr);
+}
+
+size_t SimpleRenderSystem::writeInstances(
+    std::vector<SveGameObject>& gameObjects, InstanceData* out, std::vector<ModelRun>& runs) {
+    // a list is walked once, every change of model along it starts a new run and so a new draw.
+    // The lists drawn here are all one model, which makes that one draw per list
+    InstanceData* first = out;
+    runs.clear();
+    for (auto& obj : gameObjects) {
+        SveModel* model = obj.model.get();
+        if (model == nullptr) continue;
+        if (runs.empty() || runs.back().model != model) {
+            runs.push_back({model, static_cast<size_t>(out - first), 0});
+        }
+        runs.back().count++;
+
+        // the same slow spin renderGameObjects gives every object
+        float rotation = obj.transform2d.rotation + 0.001f;
+        if (rotation >= glm::two_pi<float>()) rotation -= glm::two_pi<float>();
+        obj.transform2d.rotation = rotation;
+
+        out->offset = obj.transform2d.translation;
+        out->scale = obj.transform2d.scale;
+        out->rotation = rotation;
+        out->color = packColor(obj.color);
+        out++;
+    }
+    return out - first;
+}
+
+void SimpleRenderSystem::renderGameObjectsInstanced(const FrameInfo& frameInfo, std::vector<SveGameObject>& gameObjects) {
+    SveFrameRingBuffer::Allocation allocation =
+        frameInfo.frameRing.allocate(sizeof(InstanceData) * gameObjects.size(), alignof(InstanceData));
+    if (!allocation) {
+        renderGameObjects(frameInfo.commandBuffer, gameObjects);
+        return;
+    }
+    writeInstances(gameObjects, static_cast<InstanceData*>(allocation.mapped), modelRuns);
+
+    instancedPipeline->bind(frameInfo.commandBuffer);
+    for (const auto& run : modelRuns) {
+        run.model->bind(frameInfo.commandBuffer);
+        VkBuffer buffers[] = {allocation.buffer};
+        VkDeviceSize offsets[] = {allocation.offset + sizeof(InstanceData) * run.first};
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, buffers, offsets);
+        run.model->draw(frameInfo.commandBuffer, static_cast<uint32_t>(run.count));
+    }
+}
+
+void SimpleRenderSystem::recordCull(
+    const FrameInfo& frameInfo, std::vector<SveGameObject>& gameObjects, const CullView& view, CulledDraws& draws) {
+    SveFrameRingBuffer& frameRing = frameInfo.frameRing;
+    draws.gameObjects = nullptr;
+    draws.buffer = VK_NULL_HANDLE;
+    draws.runs.clear();
+
+    // at most a run per object, the unused commands cost a few bytes of ring
+    VkDeviceSize instanceBytes = sizeof(InstanceData) * gameObjects.size();
+    SveFrameRingBuffer::Allocation input = frameRing.allocate(instanceBytes, alignof(InstanceData));
+    SveFrameRingBuffer::Allocation output = frameRing.allocate(instanceBytes, alignof(InstanceData));
+    SveFrameRingBuffer::Allocation commands =
+        frameRing.allocate(sizeof(VkDrawIndirectCommand) * gameObjects.size(), alignof(VkDrawIndirectCommand));
+    if (!input || !output || !commands) {
+        // renderCulled falls back to renderGameObjects, which applies the spin itself
+        draws.gameObjects = &gameObjects;
+        return;
+    }
+
+    size_t instanceCount = writeInstances(gameObjects, static_cast<InstanceData*>(input.mapped), draws.runs);
+    if (instanceCount == 0) return;
+    draws.buffer = input.buffer;
+    draws.instanceOffset = output.offset;
+    draws.commandOffset = commands.offset;
+
+    // the shader only bumps instanceCount, the rest of each command is known here. Host writes to
+    // coherent memory are visible to the submission without a barrier
+    auto* command = static_cast<VkDrawIndirectCommand*>(commands.mapped);
+    for (const auto& run : draws.runs) {
+        *command++ = {run.model->getVertexCount(), 0, 0, 0};
+    }
+
+    updateCullDescriptorSet(frameRing);
+    cullPipeline->bind(frameInfo.commandBuffer);
+    uint32_t dynamicOffset = static_cast<uint32_t>(frameRing.getFrameOffset());
+    vkCmdBindDescriptorSets(
+        frameInfo.commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        cullPipelineLayout,
+        0,
+        1,
+        &cullDescriptorSet,
+        1,
+        &dynamicOffset);
+
+    auto toWord = [&](VkDeviceSize offset) {
+        return static_cast<uint32_t>((offset - frameRing.getFrameOffset()) / sizeof(uint32_t));
+    };
+
+    // a dispatch per run, they write disjoint ranges and need no barriers between them
+    for (size_t r = 0; r < draws.runs.size(); r++) {
+        const ModelRun& run = draws.runs[r];
+        CullPushConstantData push{};
+        push.viewMin = view.min;
+        push.viewMax = view.max;
+        push.instanceCount = static_cast<uint32_t>(run.count);
+        push.inputWord = toWord(input.offset + sizeof(InstanceData) * run.first);
+        push.outputWord = toWord(output.offset + sizeof(InstanceData) * run.first);
+        push.commandWord = toWord(commands.offset + sizeof(VkDrawIndirectCommand) * r);
+        push.radius = run.model->getBoundingRadius();
+        vkCmdPushConstants(
+            frameInfo.commandBuffer,
+            cullPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstantData),
+            &push);
+        vkCmdDispatch(frameInfo.commandBuffer, (push.instanceCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+    }
+
+    VkMemoryBarrier drawBarrier{};
+    drawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    drawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(
+        frameInfo.commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0,
+        1,
+        &drawBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+void SimpleRenderSystem::renderCulled(const FrameInfo& frameInfo, const CulledDraws& draws) {
+    if (draws.gameObjects != nullptr) renderGameObjects(frameInfo.commandBuffer, *draws.gameObjects);
+    if (draws.buffer == VK_NULL_HANDLE) return;
+
+    // Each run has its own model, so a draw per run either way and the count of draws is known
+    // here. vkCmdDrawIndirectCount would only help if the gpu also decided which models to draw
+    instancedPipeline->bind(frameInfo.commandBuffer);
+    for (size_t r = 0; r < draws.runs.size(); r++) {
+        const ModelRun& run = draws.runs[r];
+        run.model->bind(frameInfo.commandBuffer);
+        VkBuffer buffers[] = {draws.buffer};
+        VkDeviceSize offsets[] = {draws.instanceOffset + sizeof(InstanceData) * run.first};
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, buffers, offsets);
+        vkCmdDrawIndirect(
+            frameInfo.commandBuffer,
+            draws.buffer,
+            draws.commandOffset + sizeof(VkDrawIndirectCommand) * r,
+            1,
+            sizeof(VkDrawIndirectCommand));
+    }
+}
+
+uint32_t SimpleRenderSystem::createStaticDrawList() {
+    staticDrawLists.emplace_back();
+    return static_cast<uint32_t>(staticDrawLists.size() - 1);
+}
+
+void SimpleRenderSystem::destroyStaticFrame(StaticFrame& frame) {
+    if (frame.buffer == VK_NULL_HANDLE) return;
+    vkUnmapMemory(sveDevice.device(), frame.memory);
+    vkDestroyBuffer(sveDevice.device(), frame.buffer, nullptr);
+    vkFreeMemory(sveDevice.device(), frame.memory, nullptr);
+    frame = StaticFrame{};
+}
+
+void SimpleRenderSystem::renderStaticGameObjects(
+    const FrameInfo& frameInfo, uint32_t staticDrawList, std::vector<SveGameObject>& gameObjects) {
+    SveSecondaryCommandBuffers& secondaryCommandBuffers = frameInfo.secondaryCommandBuffers;
+    StaticDrawList& list = staticDrawLists[staticDrawList];
+    if (list.cachedId == NO_CACHED_ID) list.cachedId = secondaryCommandBuffers.createCached();
+    StaticFrame& frame = list.frames[frameInfo.frameIndex];
+
+    // the frame's fence has signaled, nothing reads its old buffer anymore
+    if (frame.capacity < gameObjects.size()) {
+        size_t capacity = std::max(gameObjects.size(), frame.capacity * 2);
+        destroyStaticFrame(frame);
+        sveDevice.createBuffer(
+            sizeof(InstanceData) * capacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            frame.buffer,
+            frame.memory);
+        void* data;
+        vkMapMemory(sveDevice.device(), frame.memory, 0, sizeof(InstanceData) * capacity, 0, &data);
+        frame.mapped = static_cast<InstanceData*>(data);
+        frame.capacity = capacity;
+        secondaryCommandBuffers.invalidateCached(list.cachedId);
+    }
+
+    writeInstances(gameObjects, frame.mapped, modelRuns);
+    bool sameRuns = std::equal(
+        modelRuns.begin(), modelRuns.end(), frame.recordedRuns.begin(), frame.recordedRuns.end(),
+        [](const ModelRun& a, const ModelRun& b) { return a.model == b.model && a.first == b.first && a.count == b.count; });
+    if (!sameRuns) secondaryCommandBuffers.invalidateCached(list.cachedId);
+
+    VkCommandBuffer commandBuffer = secondaryCommandBuffers.getCached(list.cachedId);
+    if (commandBuffer == VK_NULL_HANDLE) {
+        SVE_PROFILE_SCOPE("record static draw list");
+        commandBuffer = secondaryCommandBuffers.beginCached(list.cachedId);
+        instancedPipeline->bind(commandBuffer);
+        for (const auto& run : modelRuns) {
+            run.model->bind(commandBuffer);
+            VkBuffer buffers[] = {frame.buffer};
+            VkDeviceSize offsets[] = {sizeof(InstanceData) * run.first};
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+            run.model->draw(commandBuffer, static_cast<uint32_t>(run.count));
+        }
+        secondaryCommandBuffers.end(commandBuffer);
+        frame.recordedRuns = modelRuns;
+    }
+    vkCmdExecuteCommands(frameInfo.commandBuffer, 1, &commandBuffer);
+}
+
 void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<SveGameObject>& gameObjects) {
+    renderGameObjects(commandBuffer, gameObjects.data(), gameObjects.data() + gameObjects.size());
+}
+
+void SimpleRenderSystem::renderGameObjectsParallel(
+    const FrameInfo& frameInfo, SveThreadPool& threadPool, std::vector<SveGameObject>& gameObjects) {
+    if (gameObjects.empty()) return;
+
+    // chunks are fixed by the list, whichever worker takes one records it with its own pool
+    size_t chunkCount = (gameObjects.size() + OBJECTS_PER_SECONDARY - 1) / OBJECTS_PER_SECONDARY;
+    chunkCommandBuffers.assign(chunkCount, VK_NULL_HANDLE);
+    threadPool.parallelFor(
+        gameObjects.size(), OBJECTS_PER_SECONDARY, [&](size_t begin, size_t end, unsigned int workerIndex) {
+            SVE_PROFILE_SCOPE("record secondary");
+            // a pool without workers hands over the whole list in one range
+            for (size_t chunk = begin; chunk < end; chunk += OBJECTS_PER_SECONDARY) {
+                size_t chunkEnd = std::min(chunk + OBJECTS_PER_SECONDARY, end);
+                VkCommandBuffer commandBuffer = frameInfo.secondaryCommandBuffers.begin(workerIndex);
+                renderGameObjects(commandBuffer, gameObjects.data() + chunk, gameObjects.data() + chunkEnd);
+                frameInfo.secondaryCommandBuffers.end(commandBuffer);
+                chunkCommandBuffers[chunk / OBJECTS_PER_SECONDARY] = commandBuffer;
+            }
+        });
+
+    vkCmdExecuteCommands(
+        frameInfo.commandBuffer, static_cast<uint32_t>(chunkCommandBuffers.size()), chunkCommandBuffers.data());
+}
+
+void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, SveGameObject* begin, SveGameObject* end) {
     svePipeline->bind(commandBuffer);
 
-    for (auto& obj : gameObjects) {
+    for (SveGameObject* it = begin; it != end; it++) {
+        SveGameObject& obj = *it;
         obj.transform2d.rotation = glm::mod(obj.transform2d.rotation + 0.001f, glm::two_pi<float>());
 
         SimplePushConstantData push{};
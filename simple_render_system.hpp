@@ -1,34 +1,143 @@
 #pragma once
 
+#include "sve_compute_pipeline.hpp"
 #include "sve_device.hpp"
+#include "sve_frame_info.hpp"
 #include "sve_game_object.hpp"
 #include "sve_pipeline.hpp"
 #include "sve_renderer.hpp"
+#include "sve_thread_pool.hpp"
 #include "sve_window.hpp"
 
 // std
+#include <array>
 #include <memory>
 #include <vector>
 
 namespace sve {
 class SimpleRenderSystem {
    public:
+    static constexpr uint32_t CULL_WORKGROUP_SIZE = 256;
+
+    // consecutive objects sharing a model, drawn as one instanced draw
+    struct ModelRun {
+        SveModel *model;
+        size_t first;
+        size_t count;
+    };
+
+    // region of clip space to keep, objects whose bounds miss it are culled
+    struct CullView {
+        glm::vec2 min{-1.f};
+        glm::vec2 max{1.f};
+    };
+
+    // what recordCull leaves for renderCulled, keep one per list across frames so its runs keep
+    // their capacity
+    struct CulledDraws {
+        std::vector<SveGameObject> *gameObjects{nullptr};  // set when the frame ring was full, drawn the plain way
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceSize instanceOffset{0};  // survivors, packed at the start of each run's range
+        VkDeviceSize commandOffset{0};   // a VkDrawIndirectCommand per run
+        std::vector<ModelRun> runs;
+    };
+
     SimpleRenderSystem(SveDevice &device, VkRenderPass renderPass);
     ~SimpleRenderSystem();
 
     SimpleRenderSystem(const SimpleRenderSystem &) = delete;
     SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
+    static constexpr size_t OBJECTS_PER_SECONDARY = 4096;
+
+    // one push constant block and draw per object
     void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<SveGameObject> &gameObjects);
 
+    // renderGameObjects split into chunks that the pool's threads record into secondary command
+    // buffers, run in list order from frameInfo's command buffer. The swap chain render pass has
+    // to be begun for secondary command buffers with at least threadPool.size() workers
+    void renderGameObjectsParallel(
+        const FrameInfo &frameInfo, SveThreadPool &threadPool, std::vector<SveGameObject> &gameObjects);
+
+    // Same picture with one draw per run of objects sharing a model, so keep those together in the
+    // list. Every object's transform and color is copied into the frame ring and the vertex shader
+    // builds the matrix, so the cpu cost per object is a few stores. Falls back to renderGameObjects
+    // for a frame whose ring is full, the ring grows before the next time that frame comes round
+    void renderGameObjectsInstanced(const FrameInfo &frameInfo, std::vector<SveGameObject> &gameObjects);
+
+    // Instanced drawing where the gpu decides what is drawn. Outside of a render pass, recordCull
+    // copies the instances into the frame ring like renderGameObjectsInstanced and dispatches a
+    // compute pass that keeps the ones overlapping view, compacts them and counts them into an
+    // indirect draw per model run. renderCulled then records those draws inside the render pass,
+    // its cost depends on the number of models and not on how many objects there are or survive
+    void recordCull(
+        const FrameInfo &frameInfo, std::vector<SveGameObject> &gameObjects, const CullView &view, CulledDraws &draws);
+    void renderCulled(const FrameInfo &frameInfo, const CulledDraws &draws);
+
+    // A list whose objects move, but whose length and models rarely change, like the vector field
+    // glyphs. Its instanced draws are recorded once into cached secondary command buffers and run
+    // from frameInfo's command buffer every frame, only the instances are written again. The draws
+    // are recorded again when the list's models or length change, or the swap chain was recreated.
+    // The swap chain render pass has to be begun for secondary command buffers
+    uint32_t createStaticDrawList();
+    void renderStaticGameObjects(
+        const FrameInfo &frameInfo, uint32_t staticDrawList, std::vector<SveGameObject> &gameObjects);
+
    private:
+    // per instance vertex data of simple_instanced.vert
+    struct InstanceData {
+        glm::vec2 offset;
+        glm::vec2 scale;
+        float rotation;
+        uint32_t color;  // rgba8 unorm
+    };
+
+    // Instances of a static draw list, at the same place every time its frame comes round because
+    // the recorded draws point there. The frame ring hands out a new offset every frame
+    struct StaticFrame {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        InstanceData *mapped{nullptr};
+        size_t capacity{0};               // in instances
+        std::vector<ModelRun> recordedRuns;  // what the cached buffer draws
+    };
+
+    struct StaticDrawList {
+        uint32_t cachedId{NO_CACHED_ID};  // SveSecondaryCommandBuffers id, made on first use
+        std::array<StaticFrame, SveSwapChain::MAX_FRAMES_IN_FLIGHT> frames{};
+    };
+
+    static constexpr uint32_t NO_CACHED_ID = ~0u;
+
+    void renderGameObjects(VkCommandBuffer commandBuffer, SveGameObject *begin, SveGameObject *end);
+    void destroyStaticFrame(StaticFrame &frame);
     void createPipelineLayout();
     void createPipeline(VkRenderPass renderPass);
+    void createInstancedPipeline(VkRenderPass renderPass);
+    void createCullPipeline();
+    // points the cull descriptor at the frame ring's current buffer
+    void updateCullDescriptorSet(const SveFrameRingBuffer &frameRing);
+    // applies the spin and fills out and runs, returns the number of instances written
+    size_t writeInstances(std::vector<SveGameObject> &gameObjects, InstanceData *out, std::vector<ModelRun> &runs);
 
     SveDevice &sveDevice;
 
     std::unique_ptr<SvePipeline> svePipeline;
+    std::unique_ptr<SvePipeline> instancedPipeline;
     VkPipelineLayout pipelineLayout;
+
+    std::vector<ModelRun> modelRuns;
+    std::vector<VkCommandBuffer> chunkCommandBuffers;  // indexed by chunk, so the draw order stays the list's
+    std::vector<StaticDrawList> staticDrawLists;
+
+    // one dynamic storage buffer over a frame's part of the frame ring, the dynamic offset picks the frame
+    VkDescriptorSetLayout cullSetLayout;
+    VkDescriptorPool cullDescriptorPool;
+    VkDescriptorSet cullDescriptorSet;
+    VkPipelineLayout cullPipelineLayout;
+    std::unique_ptr<SveComputePipeline> cullPipeline;
+    VkBuffer cullSetBuffer{VK_NULL_HANDLE};  // what cullDescriptorSet points at, the ring only grows
+    VkDeviceSize cullSetRange{0};
 };
 
 }  // namespace sve
\ No newline at end of file
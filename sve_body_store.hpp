@@ -0,0 +1,69 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sve {
+
+// Structure of arrays storage for the bodies the physics systems operate on. Keeping each
+// component in its own contiguous array means the force loops only pull in the data they actually
+// read, unlike walking SveGameObjects with their models, colors and transforms.
+class SveBodyStore {
+   public:
+    size_t size() const { return mass.size(); }
+    bool empty() const { return mass.empty(); }
+
+    void reserve(size_t count) {
+        positionX.reserve(count);
+        positionY.reserve(count);
+        velocityX.reserve(count);
+        velocityY.reserve(count);
+        mass.reserve(count);
+        id.reserve(count);
+    }
+
+    void resize(size_t count) {
+        positionX.resize(count);
+        positionY.resize(count);
+        velocityX.resize(count);
+        velocityY.resize(count);
+        mass.resize(count, 1.0f);
+        for (size_t i = id.size(); i < count; i++) {
+            id.push_back(static_cast<uint32_t>(i));
+        }
+        id.resize(count);
+    }
+
+    void clear() { resize(0); }
+
+    void addBody(glm::vec2 position, glm::vec2 velocity, float bodyMass) {
+        positionX.push_back(position.x);
+        positionY.push_back(position.y);
+        velocityX.push_back(velocity.x);
+        velocityY.push_back(velocity.y);
+        mass.push_back(bodyMass);
+        id.push_back(static_cast<uint32_t>(id.size()));
+    }
+
+    glm::vec2 position(size_t i) const { return {positionX[i], positionY[i]}; }
+    glm::vec2 velocity(size_t i) const { return {velocityX[i], velocityY[i]}; }
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> mass;
+
+    // stable identity of each body, new bodies are numbered by their index. The systems never
+    // reorder the arrays, this is for tools that follow bodies across snapshots
+    std::vector<uint32_t> id;
+};
+
+}  // namespace sve
@@ -0,0 +1,53 @@
+#include "sve_compute_pipeline.hpp"
+
+#include "sve_pipeline.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+namespace sve {
+
+SveComputePipeline::SveComputePipeline(SveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+    : sveDevice{device} {
+    assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipeline layout provided");
+
+    auto compShaderCode = SvePipeline::readFile(compFilepath);
+
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = compShaderCode.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compShaderCode.data());
+    if (vkCreateShaderModule(sveDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+
+    VkPipelineShaderStageCreateInfo shaderStage{};
+    shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStage.module = compShaderModule;
+    shaderStage.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = shaderStage;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(sveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+}
+
+SveComputePipeline::~SveComputePipeline() {
+    vkDestroyShaderModule(sveDevice.device(), compShaderModule, nullptr);
+    vkDestroyPipeline(sveDevice.device(), computePipeline, nullptr);
+}
+
+void SveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+}
+
+}  // namespace sve
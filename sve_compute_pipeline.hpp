@@ -0,0 +1,27 @@
+#pragma once
+
+#include "sve_device.hpp"
+
+// std
+#include <string>
+
+namespace sve {
+
+// Compute counterpart of SvePipeline, a single shader stage and the layout it runs with
+class SveComputePipeline {
+   public:
+    SveComputePipeline(SveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+    ~SveComputePipeline();
+
+    SveComputePipeline(const SveComputePipeline&) = delete;
+    SveComputePipeline& operator=(const SveComputePipeline&) = delete;
+
+    void bind(VkCommandBuffer commandBuffer);
+
+   private:
+    SveDevice& sveDevice;
+    VkPipeline computePipeline;
+    VkShaderModule compShaderModule;
+};
+
+}  // namespace sve
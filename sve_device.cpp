@@ -47,7 +47,7 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-SveDevice::SveDevice(SveWindow &window) : window{window} {
+SveDevice::SveDevice(SveWindow &window) : window{&window} {
     createInstance();
     setupDebugMessenger();
     createSurface();
@@ -56,6 +56,15 @@ SveDevice::SveDevice(SveWindow &window) : window{window} {
     createCommandPool();
 }
 
+SveDevice::SveDevice() {
+    deviceExtensions.clear();
+    createInstance();
+    setupDebugMessenger();
+    pickPhysicalDevice();
+    createLogicalDevice();
+    createCommandPool();
+}
+
 SveDevice::~SveDevice() {
     vkDestroyCommandPool(device_, commandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
@@ -64,7 +73,9 @@ SveDevice::~SveDevice() {
         DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(instance, surface_, nullptr);
+    if (surface_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance, surface_, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
 }
 
@@ -79,7 +90,7 @@ void SveDevice::createInstance() {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_1;
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -190,15 +201,16 @@ void SveDevice::createCommandPool() {
     }
 }
 
-void SveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+void SveDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
 bool SveDevice::isDeviceSuitable(VkPhysicalDevice device) {
     QueueFamilyIndices indices = findQueueFamilies(device);
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    // nothing is presented without a window
+    bool swapChainAdequate = window == nullptr;
+    if (extensionsSupported && window != nullptr) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
@@ -258,11 +270,13 @@ bool SveDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> SveDevice::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions{};
+    if (window != nullptr) {
+        uint32_t glfwExtensionCount = 0;
+        const char **glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -325,12 +339,20 @@ QueueFamilyIndices SveDevice::findQueueFamilies(VkPhysicalDevice device) {
 
     int i = 0;
     for (const auto &queueFamily : queueFamilies) {
-        if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        // gpu physics records its dispatches into the frame's command buffer, so the graphics queue
+        // has to take compute work too. Every device with graphics has such a family
+        if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT &&
+            queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
             indices.graphicsFamily = i;
             indices.graphicsFamilyHasValue = true;
         }
+        // a headless device never presents, its graphics queue stands in for the present queue
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        } else {
+            presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+        }
         if (queueFamily.queueCount > 0 && presentSupport) {
             indices.presentFamily = i;
             indices.presentFamilyHasValue = true;
@@ -345,6 +367,14 @@ QueueFamilyIndices SveDevice::findQueueFamilies(VkPhysicalDevice device) {
     return indices;
 }
 
+uint32_t SveDevice::graphicsTimestampValidBits() {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+}
+
 SwapChainSupportDetails SveDevice::querySwapChainSupport(VkPhysicalDevice device) {
     SwapChainSupportDetails details;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
@@ -31,6 +31,9 @@ class SveDevice {
 #endif
 
     SveDevice(SveWindow &window);
+    // Headless device for compute only use, no glfw, surface or swapchain extension is involved.
+    // presentQueue() is the graphics queue and surface() is VK_NULL_HANDLE
+    SveDevice();
     ~SveDevice();
 
     // Not copyable or movable
@@ -48,6 +51,8 @@ class SveDevice {
     SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+    // bits of a timestamp written on the graphics queue that hold time, 0 if it can't write them
+    uint32_t graphicsTimestampValidBits();
     VkFormat findSupportedFormat(
         const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -93,16 +98,16 @@ class SveDevice {
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    SveWindow &window;
+    SveWindow *window{nullptr};  // null for a headless device
     VkCommandPool commandPool;
 
     VkDevice device_;
-    VkSurfaceKHR surface_;
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
 
     const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-    const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 
 }  // namespace sve
\ No newline at end of file
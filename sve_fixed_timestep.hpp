@@ -0,0 +1,40 @@
+#pragma once
+
+// std
+#include <algorithm>
+
+namespace sve {
+
+// Turns variable frame times into a whole number of fixed simulation ticks. Real time is
+// accumulated and paid out one tickDelta at a time, whatever is left over is carried to the next
+// frame and exposed as alpha so rendering can blend between the last two simulated states.
+class SveFixedTimestep {
+   public:
+    // maxTicksPerFrame caps the catch up after a long frame (a stall, dragging the window...),
+    // time beyond it is dropped so the simulation slows down instead of falling further behind
+    explicit SveFixedTimestep(float tickDelta, unsigned int maxTicksPerFrame = 8)
+        : tickDelta{tickDelta}, maxTicksPerFrame{maxTicksPerFrame} {}
+
+    // adds frameTime seconds of real time and returns how many ticks to run for it
+    unsigned int advance(float frameTime) {
+        accumulator += std::max(frameTime, 0.f);
+        unsigned int ticks = static_cast<unsigned int>(accumulator / tickDelta);
+        if (ticks > maxTicksPerFrame) {
+            ticks = maxTicksPerFrame;
+            accumulator = tickDelta * ticks;
+        }
+        accumulator -= tickDelta * ticks;
+        return ticks;
+    }
+
+    // fraction of a tick the simulation is behind real time, in [0, 1)
+    float getAlpha() const { return std::min(accumulator / tickDelta, 1.f); }
+    float getTickDelta() const { return tickDelta; }
+
+   private:
+    const float tickDelta;
+    const unsigned int maxTicksPerFrame;
+    float accumulator{0.f};
+};
+
+}  // namespace sve
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "sve_device.hpp"
+#include "sve_frame_ring_buffer.hpp"
+#include "sve_secondary_command_buffers.hpp"
+
+namespace sve {
+
+// What a render system needs to know about the frame it is recording into
+struct FrameInfo {
+    int frameIndex;  // frame in flight, selects per frame resources
+    VkCommandBuffer commandBuffer;
+    SveFrameRingBuffer &frameRing;  // scratch memory the gpu reads until this frame's fence signals
+    SveSecondaryCommandBuffers &secondaryCommandBuffers;
+};
+
+}  // namespace sve
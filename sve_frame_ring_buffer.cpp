@@ -0,0 +1,76 @@
+#include "sve_frame_ring_buffer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace sve {
+
+SveFrameRingBuffer::SveFrameRingBuffer(SveDevice &device, VkDeviceSize bytesPerFrame)
+    : sveDevice{device}, bytesPerFrame{bytesPerFrame} {
+    const VkPhysicalDeviceLimits &limits = sveDevice.properties.limits;
+    defaultAlignment = std::max<VkDeviceSize>(
+        {16, limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment});
+    // every frame's part starts aligned, so allocations only have to align relative to it
+    this->bytesPerFrame = (bytesPerFrame + defaultAlignment - 1) & ~(defaultAlignment - 1);
+    createBuffer();
+}
+
+SveFrameRingBuffer::~SveFrameRingBuffer() { destroyBuffer(); }
+
+void SveFrameRingBuffer::createBuffer() {
+    VkDeviceSize size = bytesPerFrame * SveSwapChain::MAX_FRAMES_IN_FLIGHT;
+    sveDevice.createBuffer(
+        size,
+        USAGE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffer,
+        memory);
+
+    // coherent memory stays mapped for the buffer's whole life, writes need no flush
+    void *data;
+    vkMapMemory(sveDevice.device(), memory, 0, size, 0, &data);
+    mapped = static_cast<uint8_t *>(data);
+}
+
+void SveFrameRingBuffer::destroyBuffer() {
+    vkUnmapMemory(sveDevice.device(), memory);
+    vkDestroyBuffer(sveDevice.device(), buffer, nullptr);
+    vkFreeMemory(sveDevice.device(), memory, nullptr);
+    mapped = nullptr;
+}
+
+void SveFrameRingBuffer::beginFrame(int frameIndex) {
+    assert(frameIndex >= 0 && frameIndex < static_cast<int>(SveSwapChain::MAX_FRAMES_IN_FLIGHT));
+
+    if (requiredBytes > bytesPerFrame) {
+        // other frames in flight still read the old buffer, this is rare enough to just wait
+        vkDeviceWaitIdle(sveDevice.device());
+        destroyBuffer();
+        bytesPerFrame = (requiredBytes + requiredBytes / 2 + defaultAlignment - 1) & ~(defaultAlignment - 1);
+        createBuffer();
+    }
+
+    frameBegin = bytesPerFrame * frameIndex;
+    frameEnd = frameBegin + bytesPerFrame;
+    head = frameBegin;
+}
+
+SveFrameRingBuffer::Allocation SveFrameRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (alignment == 0) alignment = defaultAlignment;
+    assert((alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+    VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+    requiredBytes = std::max(requiredBytes, offset + size - frameBegin);
+    if (offset + size > frameEnd) return {};
+
+    head = offset + size;
+    Allocation allocation{};
+    allocation.buffer = buffer;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.mapped = mapped + offset;
+    return allocation;
+}
+
+}  // namespace sve
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "sve_device.hpp"
+#include "sve_swap_chain.hpp"
+
+// std
+#include <cstdint>
+
+namespace sve {
+
+// One persistently mapped, host visible buffer split into a part per frame in flight, handing out
+// sub-allocations of its frame's part from a bump pointer. An allocation stays valid until the fence
+// of the frame it was made in signals, so per frame data (instances, uniforms, compute parameters)
+// is written straight into memory the gpu reads, with no allocation or map call in the frame loop.
+class SveFrameRingBuffer {
+   public:
+    struct Allocation {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};  // into buffer
+        VkDeviceSize size{0};
+        void *mapped{nullptr};  // host pointer to the first byte
+
+        explicit operator bool() const { return mapped != nullptr; }
+    };
+
+    static constexpr VkBufferUsageFlags USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    SveFrameRingBuffer(SveDevice &device, VkDeviceSize bytesPerFrame);
+    ~SveFrameRingBuffer();
+
+    SveFrameRingBuffer(const SveFrameRingBuffer &) = delete;
+    SveFrameRingBuffer &operator=(const SveFrameRingBuffer &) = delete;
+
+    // Starts handing out frameIndex's part again, call once its fence has signaled. A frame that ran
+    // out of space last time it was used grows the buffer first, which waits for the device to idle
+    void beginFrame(int frameIndex);
+
+    // size bytes aligned to alignment, a power of two. 0 picks the device's uniform and storage
+    // buffer offset alignment so the allocation can be bound as either. Returns an empty allocation
+    // when the frame's part is full, the next beginFrame makes room
+    Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+    VkBuffer getBuffer() const { return buffer; }
+    VkDeviceSize getBytesPerFrame() const { return bytesPerFrame; }
+    // where the current frame's part starts, as a dynamic offset it binds just that part
+    VkDeviceSize getFrameOffset() const { return frameBegin; }
+
+   private:
+    void createBuffer();
+    void destroyBuffer();
+
+    SveDevice &sveDevice;
+    VkDeviceSize bytesPerFrame;
+    VkDeviceSize defaultAlignment;
+
+    VkBuffer buffer{VK_NULL_HANDLE};
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    uint8_t *mapped{nullptr};
+
+    VkDeviceSize frameBegin{0};
+    VkDeviceSize frameEnd{0};
+    VkDeviceSize head{0};
+    // most a frame has asked for since the buffer was last sized, including what didn't fit
+    VkDeviceSize requiredBytes{0};
+};
+
+}  // namespace sve
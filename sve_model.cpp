@@ -1,6 +1,7 @@
 #include "sve_model.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -17,6 +18,9 @@ SveModel::~SveModel() {
 
 void SveModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
     vertexCount = static_cast<uint32_t>(vertices.size());
+    for (const Vertex& vertex : vertices) {
+        boundingRadius = std::max(boundingRadius, glm::length(vertex.position));
+    }
     // assert(vertexCount >= 3 && "Vertex count must be at least 3.");
     VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
     sveDevice.createBuffer(
@@ -32,8 +36,8 @@ void SveModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
     vkUnmapMemory(sveDevice.device(), vertexBufferMemory);
 }
 
-void SveModel::draw(VkCommandBuffer commandBuffer) {
-    vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+void SveModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount) {
+    vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
 }
 
 void SveModel::bind(VkCommandBuffer commandBuffer) {
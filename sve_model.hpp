@@ -29,7 +29,11 @@ class SveModel {
     SveModel &operator=(const SveModel &) = delete;
 
     void bind(VkCommandBuffer commandBuffer);
-    void draw(VkCommandBuffer commandBuffer);
+    void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1);
+
+    uint32_t getVertexCount() const { return vertexCount; }
+    // distance of the farthest vertex from the model's origin, bounds it at any rotation
+    float getBoundingRadius() const { return boundingRadius; }
 
    private:
     void createVertexBuffers(const std::vector<Vertex> &vertices);
@@ -38,6 +42,7 @@ class SveModel {
     VkBuffer vertexBuffer;
     VkDeviceMemory vertexBufferMemory;
     uint32_t vertexCount;
+    float boundingRadius{0.f};
 };
 
 }  // namespace sve
\ No newline at end of file
@@ -21,6 +21,8 @@ struct PipelineConfigInfo {
     VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
     std::vector<VkDynamicState> dynamicStateEnables;
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
     uint32_t subpass = 0;
@@ -38,9 +40,10 @@ class SvePipeline {
 
     static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
-   private:
+    // also used by SveComputePipeline to load spir-v
     static std::vector<char> readFile(const std::string& filepath);
 
+   private:
     void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
 
     void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
@@ -0,0 +1,175 @@
+#include "sve_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace sve {
+
+// the gpu has track 0, threads are numbered from 1 in the order they first record
+static constexpr uint32_t GPU_TRACK = 0;
+
+SveProfiler &SveProfiler::get() {
+    static SveProfiler profiler{};
+    return profiler;
+}
+
+SveProfiler::SveProfiler() {
+    gpuRing.track = GPU_TRACK;
+    gpuRing.name = "gpu";
+}
+
+SveProfiler::~SveProfiler() { stopTrace(); }
+
+SveProfiler::Ring &SveProfiler::threadRing() {
+    thread_local Ring *ring = nullptr;
+    if (ring == nullptr) {
+        // rings are kept after their thread exits, the reader may still be draining them
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        rings.push_back(std::make_unique<Ring>());
+        ring = rings.back().get();
+        ring->track = static_cast<uint32_t>(rings.size());
+        ring->name = "thread " + std::to_string(ring->track);
+    }
+    return *ring;
+}
+
+void SveProfiler::Ring::push(const char *name, uint64_t startNs, uint64_t durationNs) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    Sample &sample = samples[index & (RING_CAPACITY - 1)];
+    // pairs with the fence in drainRing, a reader that sees any of the new fields also sees the
+    // head that says this slot is being reused
+    std::atomic_thread_fence(std::memory_order_release);
+    sample.name.store(name, std::memory_order_relaxed);
+    sample.startNs.store(startNs, std::memory_order_relaxed);
+    sample.durationNs.store(durationNs, std::memory_order_relaxed);
+    head.store(index + 1, std::memory_order_release);
+}
+
+void SveProfiler::record(const char *name, uint64_t startNs, uint64_t durationNs) {
+    threadRing().push(name, startNs, durationNs);
+}
+
+void SveProfiler::recordGpu(const char *name, uint64_t startNs, uint64_t durationNs) {
+    gpuRing.push(name, startNs, durationNs);
+}
+
+void SveProfiler::setThreadName(const std::string &name) {
+    Ring &ring = threadRing();
+    std::lock_guard<std::mutex> lock{ringsMutex};
+    ring.name = name;
+}
+
+void SveProfiler::endFrame() {
+    drain();
+    if (traceWriter && nowNs() >= traceEndNs) stopTrace();
+
+    if (++frames < REPORT_INTERVAL) return;
+    report();
+    frames = 0;
+}
+
+void SveProfiler::startTrace(const std::string &path, double seconds) {
+    stopTrace();
+    // whatever was recorded before the trace started goes to the report, not the file
+    drain();
+    traceStartNs = nowNs();
+    traceEndNs = traceStartNs + static_cast<uint64_t>(seconds * 1e9);
+    traceWriter = std::make_unique<SveTraceWriter>(path, traceStartNs);
+    std::printf("tracing to %s for %.1f s\n", path.c_str(), seconds);
+}
+
+void SveProfiler::stopTrace() {
+    if (!traceWriter) return;
+    drain();
+
+    {
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        traceWriter->nameTrack(gpuRing.track, gpuRing.name);
+        for (auto &ring : rings) {
+            traceWriter->nameTrack(ring->track, ring->name);
+        }
+    }
+    traceWriter.reset();  // joins the writer, the file is complete after this
+    std::printf("trace finished after %.1f s\n", (nowNs() - traceStartNs) * 1e-9);
+    std::fflush(stdout);
+}
+
+void SveProfiler::drain() {
+    {
+        std::lock_guard<std::mutex> lock{ringsMutex};
+        for (auto &ring : rings) {
+            drainRing(*ring);
+        }
+    }
+    drainRing(gpuRing);
+    if (traceWriter) traceWriter->write(traceEvents);
+}
+
+void SveProfiler::drainRing(Ring &ring) {
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    if (head - ring.tail > RING_CAPACITY) {
+        dropped += head - ring.tail - RING_CAPACITY;
+        ring.tail = head - RING_CAPACITY;
+    }
+    for (; ring.tail < head; ring.tail++) {
+        const Ring::Sample &sample = ring.samples[ring.tail & (RING_CAPACITY - 1)];
+        const char *name = sample.name.load(std::memory_order_relaxed);
+        uint64_t startNs = sample.startNs.load(std::memory_order_relaxed);
+        uint64_t durationNs = sample.durationNs.load(std::memory_order_relaxed);
+
+        // the writer may have started reusing the slot while it was read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ring.head.load(std::memory_order_relaxed) - ring.tail >= RING_CAPACITY) {
+            dropped++;
+            continue;
+        }
+
+        // names are literals, but the same literal can have several addresses across files
+        auto stage = std::find_if(stages.begin(), stages.end(), [&](const Stage &s) {
+            return s.name == name || std::strcmp(s.name, name) == 0;
+        });
+        if (stage == stages.end()) {
+            stages.push_back({name, {}});
+            stage = stages.end() - 1;
+        }
+        stage->durations.push_back(durationNs);
+
+        if (traceWriter && startNs >= traceStartNs) {
+            traceEvents.push_back({name, ring.track, startNs, durationNs});
+        }
+    }
+}
+
+void SveProfiler::report() {
+    uint64_t now = nowNs();
+    double seconds = (now - reportStartNs) * 1e-9;
+    reportStartNs = now;
+
+    std::printf("profile over %u frames, %.1f fps\n", frames, frames / seconds);
+    std::printf("  %-36s %8s %10s %10s %10s\n", "scope", "calls", "min ms", "avg ms", "p99 ms");
+    for (Stage &stage : stages) {
+        std::vector<uint64_t> &d = stage.durations;
+        if (d.empty()) continue;
+        std::sort(d.begin(), d.end());
+        uint64_t total = 0;
+        for (uint64_t ns : d) {
+            total += ns;
+        }
+        size_t p99 = std::min(d.size() - 1, (d.size() * 99 + 99) / 100 - 1);
+        std::printf(
+            "  %-36s %8zu %10.3f %10.3f %10.3f\n",
+            stage.name,
+            d.size(),
+            d.front() * 1e-6,
+            total * 1e-6 / d.size(),
+            d[p99] * 1e-6);
+        d.clear();  // keeps the capacity for the next report
+    }
+    if (dropped > 0) std::printf("  %llu samples dropped\n", static_cast<unsigned long long>(dropped));
+    dropped = 0;
+    std::fflush(stdout);
+}
+
+}  // namespace sve
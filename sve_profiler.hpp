@@ -0,0 +1,129 @@
+#pragma once
+
+#include "sve_trace_writer.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// SVE_PROFILE_SCOPE("name") times the rest of the enclosing scope, SVE_PROFILE_FRAME() marks the end
+// of a frame on the render thread and SVE_PROFILE_THREAD("name") names the calling thread in traces.
+// All of them compile to nothing when NDEBUG is defined, like the validation layers
+#ifndef NDEBUG
+#define SVE_PROFILE_ENABLED 1
+#define SVE_PROFILE_CONCAT_INNER(a, b) a##b
+#define SVE_PROFILE_CONCAT(a, b) SVE_PROFILE_CONCAT_INNER(a, b)
+#define SVE_PROFILE_SCOPE(name) ::sve::SveProfileScope SVE_PROFILE_CONCAT(sveProfileScope, __LINE__){name}
+#define SVE_PROFILE_FRAME() ::sve::SveProfiler::get().endFrame()
+#define SVE_PROFILE_THREAD(name) ::sve::SveProfiler::get().setThreadName(name)
+#else
+#define SVE_PROFILE_ENABLED 0
+#define SVE_PROFILE_SCOPE(name)
+#define SVE_PROFILE_FRAME()
+#define SVE_PROFILE_THREAD(name)
+#endif
+
+namespace sve {
+
+// Collects the timings of profile scopes from every thread. Every frame the render thread drains
+// them, every REPORT_INTERVAL frames it prints min, avg and p99 of each scope over those frames, and
+// while a trace is running every sample also goes to the trace file. Recording never locks, each
+// thread writes into its own ring and only the thread calling endFrame reads them.
+class SveProfiler {
+   public:
+    static constexpr unsigned int REPORT_INTERVAL = 120;
+    static constexpr uint64_t RING_CAPACITY = 4096;  // samples per thread, a power of two
+
+    static SveProfiler &get();
+
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // name must outlive the profiler, scopes pass string literals
+    void record(const char *name, uint64_t startNs, uint64_t durationNs);
+    // gpu work placed on the cpu clock, shown on its own track. Only the render thread may call it
+    void recordGpu(const char *name, uint64_t startNs, uint64_t durationNs);
+    void setThreadName(const std::string &name);
+
+    // drains every thread's samples, prints the report every REPORT_INTERVAL frames and ends a
+    // trace that has run for its duration
+    void endFrame();
+
+    // Streams every sample from now on to a chrome trace json file, for seconds or until stopTrace.
+    // Call from the render thread. Throws std::runtime_error if path can't be opened
+    void startTrace(const std::string &path, double seconds);
+    void stopTrace();
+
+   private:
+    // Single producer ring, the owning thread is the only writer. The writer never waits on the
+    // reader, if it laps it the oldest samples are lost and counted as dropped. Fields are relaxed
+    // atomics so a sample being overwritten while it is read is detected rather than a data race
+    struct Ring {
+        struct Sample {
+            std::atomic<const char *> name{nullptr};
+            std::atomic<uint64_t> startNs{0};
+            std::atomic<uint64_t> durationNs{0};
+        };
+        std::array<Sample, RING_CAPACITY> samples;
+        std::atomic<uint64_t> head{0};  // samples ever written
+        uint64_t tail{0};               // next sample to read, reader only
+        uint32_t track{0};              // trace row
+        std::string name;
+
+        void push(const char *name, uint64_t startNs, uint64_t durationNs);
+    };
+
+    struct Stage {
+        const char *name;
+        std::vector<uint64_t> durations;
+    };
+
+    SveProfiler();
+    ~SveProfiler();
+
+    Ring &threadRing();
+    void drain();
+    void drainRing(Ring &ring);
+    void report();
+
+    // only locked the first time a thread records, when naming one and when draining
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    Ring gpuRing;
+
+    // reader state
+    unsigned int frames{0};
+    uint64_t reportStartNs{nowNs()};  // for the frame rate
+    std::vector<Stage> stages;
+    uint64_t dropped{0};
+
+    std::unique_ptr<SveTraceWriter> traceWriter;
+    std::vector<SveTraceWriter::Event> traceEvents;
+    uint64_t traceStartNs{0};
+    uint64_t traceEndNs{0};
+};
+
+// Times its own lifetime, use through SVE_PROFILE_SCOPE
+class SveProfileScope {
+   public:
+    explicit SveProfileScope(const char *name) : name{name}, startNs{SveProfiler::nowNs()} {}
+    ~SveProfileScope() { SveProfiler::get().record(name, startNs, SveProfiler::nowNs() - startNs); }
+
+    SveProfileScope(const SveProfileScope &) = delete;
+    SveProfileScope &operator=(const SveProfileScope &) = delete;
+
+   private:
+    const char *name;
+    uint64_t startNs;
+};
+
+}  // namespace sve
@@ -1,5 +1,7 @@
 #include "sve_renderer.hpp"
 
+#include "sve_profiler.hpp"
+
 // std
 #include <array>
 #include <cassert>
@@ -10,9 +12,15 @@ namespace sve {
 SveRenderer::SveRenderer(SveWindow &window, SveDevice &device) : sveWindow{window}, sveDevice{device} {
     recreateSwapChain();
     createCommandBuffers();
+    createQueryPool();
+    frameRing = std::make_unique<SveFrameRingBuffer>(sveDevice, FRAME_RING_BYTES);
+    secondaryCommandBuffers = std::make_unique<SveSecondaryCommandBuffers>(sveDevice);
 }
 
-SveRenderer::~SveRenderer() { freeCommandBuffers(); }
+SveRenderer::~SveRenderer() {
+    if (queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(sveDevice.device(), queryPool, nullptr);
+    freeCommandBuffers();
+}
 
 void SveRenderer::recreateSwapChain() {
     auto extent = sveWindow.getExtent();
@@ -34,6 +42,10 @@ void SveRenderer::recreateSwapChain() {
         }
     }
 
+    // the device is idle, cached secondary buffers recorded against the old render pass can be
+    // re-recorded when next used
+    if (secondaryCommandBuffers) secondaryCommandBuffers->invalidateAllCached();
+
     // we'll come back to this
 }
 
@@ -51,6 +63,92 @@ void SveRenderer::createCommandBuffers() {
     }
 }
 
+void SveRenderer::createQueryPool() {
+    gpuTimerNames.resize(SveSwapChain::MAX_FRAMES_IN_FLIGHT);
+    submitNs.resize(SveSwapChain::MAX_FRAMES_IN_FLIGHT, 0);
+
+    uint32_t validBits = sveDevice.graphicsTimestampValidBits();
+    if (validBits == 0) return;  // timers stay off, beginGpuTimer hands out NO_GPU_TIMER
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    timestampPeriodNs = sveDevice.properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = SveSwapChain::MAX_FRAMES_IN_FLIGHT * MAX_GPU_TIMERS * 2;
+
+    if (vkCreateQueryPool(sveDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+void SveRenderer::readGpuTimers(int frameIndex) {
+    std::vector<const char *> &names = gpuTimerNames[frameIndex];
+    if (names.empty()) return;
+
+    // the fence of this frame has signaled, so the results are there. Availability is asked for
+    // anyway so a timer that was never ended is skipped instead of stalling
+    uint32_t firstQuery = frameIndex * MAX_GPU_TIMERS * 2;
+    std::array<uint64_t, MAX_GPU_TIMERS * 2 * 2> results{};  // value and availability per query
+    VkResult result = vkGetQueryPoolResults(
+        sveDevice.device(),
+        queryPool,
+        firstQuery,
+        static_cast<uint32_t>(names.size() * 2),
+        sizeof(results),
+        results.data(),
+        sizeof(uint64_t) * 2,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    gpuTimings.clear();
+    if (result == VK_SUCCESS || result == VK_NOT_READY) {
+        // the gpu clock has an unknown offset from the cpu one, timers are placed relative to the
+        // frame's first timestamp as if that ran when the frame was submitted
+        uint64_t frameBegin = results[0] & timestampMask;
+        for (size_t timer = 0; timer < names.size(); timer++) {
+            const uint64_t *begin = &results[timer * 4];
+            const uint64_t *end = &results[timer * 4 + 2];
+            if (begin[1] == 0 || end[1] == 0) continue;
+
+            uint64_t beginTicks = begin[0] & timestampMask;
+            uint64_t endTicks = end[0] & timestampMask;
+            GpuTiming timing{};
+            timing.name = names[timer];
+            timing.startNs =
+                submitNs[frameIndex] + static_cast<uint64_t>(((beginTicks - frameBegin) & timestampMask) * timestampPeriodNs);
+            timing.durationNs = static_cast<uint64_t>(((endTicks - beginTicks) & timestampMask) * timestampPeriodNs);
+            gpuTimings.push_back(timing);
+#if SVE_PROFILE_ENABLED
+            SveProfiler::get().recordGpu(timing.name, timing.startNs, timing.durationNs);
+#endif
+        }
+    }
+    names.clear();
+}
+
+uint32_t SveRenderer::beginGpuTimer(VkCommandBuffer commandBuffer, const char *name) {
+    assert(isFrameStarted && "Can't begin a gpu timer while frame is not in progress");
+    std::vector<const char *> &names = gpuTimerNames[currentFrameIndex];
+    if (queryPool == VK_NULL_HANDLE || names.size() == MAX_GPU_TIMERS) return NO_GPU_TIMER;
+
+    uint32_t timer = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    vkCmdWriteTimestamp(
+        commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, (currentFrameIndex * MAX_GPU_TIMERS + timer) * 2);
+    return timer;
+}
+
+void SveRenderer::endGpuTimer(VkCommandBuffer commandBuffer, uint32_t timer) {
+    assert(isFrameStarted && "Can't end a gpu timer while frame is not in progress");
+    if (timer == NO_GPU_TIMER) return;
+
+    vkCmdWriteTimestamp(
+        commandBuffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        queryPool,
+        (currentFrameIndex * MAX_GPU_TIMERS + timer) * 2 + 1);
+}
+
 void SveRenderer::freeCommandBuffers() {
     vkFreeCommandBuffers(
         sveDevice.device(),
@@ -74,6 +172,9 @@ VkCommandBuffer SveRenderer::beginFrame() {
     }
 
     isFrameStarted = true;
+    // acquireNextImage waited on this frame's fence, nothing the gpu reads from its part is in use
+    frameRing->beginFrame(currentFrameIndex);
+    secondaryCommandBuffers->beginFrame(currentFrameIndex);
 
     auto commandBuffer = getCurrentCommandBuffer();
     VkCommandBufferBeginInfo beginInfo{};
@@ -82,6 +183,12 @@ VkCommandBuffer SveRenderer::beginFrame() {
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
+
+    // acquireNextImage waited on this frame's fence, its last timers are done and can be reused
+    if (queryPool != VK_NULL_HANDLE) {
+        readGpuTimers(currentFrameIndex);
+        vkCmdResetQueryPool(commandBuffer, queryPool, currentFrameIndex * MAX_GPU_TIMERS * 2, MAX_GPU_TIMERS * 2);
+    }
     return commandBuffer;
 }
 
@@ -94,6 +201,7 @@ void SveRenderer::endFrame() {
         throw std::runtime_error("failed to record command buffer!");
     }
 
+    submitNs[currentFrameIndex] = SveProfiler::nowNs();
     auto result = sveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
 
     // check if window has been resized and swapchain is still valid
@@ -108,7 +216,7 @@ void SveRenderer::endFrame() {
     currentFrameIndex = (currentFrameIndex + 1) % SveSwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
-void SveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+void SveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, unsigned int secondaryWorkers) {
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "can't begin render pass on command buffer from a different frame");
 
@@ -127,6 +235,17 @@ void SveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
+    renderPassTimer = beginGpuTimer(commandBuffer, "gpu renderPass");
+    if (secondaryWorkers > 0) {
+        // secondary buffers set their own viewport and scissor, nothing else may go in the primary
+        secondaryCommandBuffers->beginRenderPass(
+            secondaryWorkers,
+            renderPassInfo.renderPass,
+            renderPassInfo.framebuffer,
+            renderPassInfo.renderArea.extent);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return;
+    }
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport viewport{};
@@ -146,5 +265,7 @@ void SveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     assert(commandBuffer == getCurrentCommandBuffer() && "can't end render pass on command buffer from a different frame");
 
     vkCmdEndRenderPass(commandBuffer);
+    endGpuTimer(commandBuffer, renderPassTimer);
+    renderPassTimer = NO_GPU_TIMER;
 }
 }  // namespace sve
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "sve_device.hpp"
+#include "sve_frame_ring_buffer.hpp"
+#include "sve_secondary_command_buffers.hpp"
 #include "sve_swap_chain.hpp"
 #include "sve_window.hpp"
 
@@ -13,6 +15,18 @@ namespace sve {
 
 class SveRenderer {
    public:
+    // gpu time spent between the two timestamps of a timer
+    struct GpuTiming {
+        const char *name;
+        uint64_t startNs;  // on the cpu clock, estimated from when the frame was submitted
+        uint64_t durationNs;
+    };
+
+    static constexpr uint32_t MAX_GPU_TIMERS = 8;  // per frame, the swap chain render pass takes one
+    static constexpr uint32_t NO_GPU_TIMER = ~0u;
+    // starting size of each frame's part of the frame ring, it grows if a frame asks for more
+    static constexpr VkDeviceSize FRAME_RING_BYTES = 32 * 1024 * 1024;
+
     SveRenderer(SveWindow &window, SveDevice &device);
     ~SveRenderer();
 
@@ -32,24 +46,61 @@ class SveRenderer {
         return currentFrameIndex;
     }
 
+    // per frame scratch memory, reset for the current frame by beginFrame
+    SveFrameRingBuffer &getFrameRing() {
+        assert(isFrameStarted && "Cannot get frame ring when frame is not in progress");
+        return *frameRing;
+    }
+
+    // command buffers continuing the swap chain render pass, for recording it on several threads
+    SveSecondaryCommandBuffers &getSecondaryCommandBuffers() {
+        assert(isFrameStarted && "Cannot get secondary command buffers when frame is not in progress");
+        return *secondaryCommandBuffers;
+    }
+
     VkCommandBuffer beginFrame();
     void endFrame();
-    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    // With secondaryWorkers above 0 the render pass is begun for secondary command buffers, that
+    // many workers can record them and the primary may only run them with vkCmdExecuteCommands
+    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, unsigned int secondaryWorkers = 0);
     void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+    // Writes timestamps around the commands recorded between the two calls, the swap chain render
+    // pass is timed without asking. name must be a string literal. Returns NO_GPU_TIMER, which
+    // endGpuTimer ignores, when the queue can't write timestamps or the frame's timers are used up
+    uint32_t beginGpuTimer(VkCommandBuffer commandBuffer, const char *name);
+    void endGpuTimer(VkCommandBuffer commandBuffer, uint32_t timer);
+
+    // Timers of the newest frame whose fence has signaled, read back when its slot comes around
+    // again so nothing waits on the gpu. They also go to the profiler on its gpu track
+    const std::vector<GpuTiming> &getGpuTimings() const { return gpuTimings; }
+
    private:
     void createCommandBuffers();
     void freeCommandBuffers();
     void recreateSwapChain();
+    void createQueryPool();
+    void readGpuTimers(int frameIndex);
 
     SveWindow &sveWindow;
     SveDevice &sveDevice;
     std::unique_ptr<SveSwapChain> sveSwapChain;
     std::vector<VkCommandBuffer> commandBuffers;
+    std::unique_ptr<SveFrameRingBuffer> frameRing;
+    std::unique_ptr<SveSecondaryCommandBuffers> secondaryCommandBuffers;
 
     uint32_t currentImageIndex;
-    int currentFrameIndex;
+    int currentFrameIndex{0};
     bool isFrameStarted{false};
+
+    // two queries per timer, MAX_GPU_TIMERS timers for each frame in flight
+    VkQueryPool queryPool{VK_NULL_HANDLE};
+    double timestampPeriodNs{0.0};
+    uint64_t timestampMask{0};
+    std::vector<std::vector<const char *>> gpuTimerNames;  // per frame in flight, indexed by timer
+    std::vector<uint64_t> submitNs;                        // per frame in flight
+    std::vector<GpuTiming> gpuTimings;
+    uint32_t renderPassTimer{NO_GPU_TIMER};
 };
 
 }  // namespace sve
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "sve_scenario.hpp"
+
+#include "sve_snapshot.hpp"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace sve {
+
+// bodies per generator chunk, also the unit the random streams are split on
+static constexpr size_t GENERATOR_CHUNK = 64 * 1024;
+
+// splitmix64, small and fast enough that drawing numbers costs less than the math done with them
+class ScenarioRng {
+   public:
+    explicit ScenarioRng(uint64_t seed) : state{seed} {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // uniform in [0, 1)
+    float uniform() { return static_cast<float>(next() >> 40) * 0x1p-24f; }
+    // uniform in (0, 1], safe to take the log of
+    float uniformOpen() { return static_cast<float>((next() >> 40) + 1) * 0x1p-24f; }
+
+   private:
+    uint64_t state;
+};
+
+static void fillBody(const BodySetDescription &set, SveBodyStore &bodies, size_t begin, size_t, ScenarioRng &) {
+    bodies.positionX[begin] = set.center.x;
+    bodies.positionY[begin] = set.center.y;
+    bodies.velocityX[begin] = set.velocity.x;
+    bodies.velocityY[begin] = set.velocity.y;
+    bodies.mass[begin] = set.mass;
+}
+
+static void fillUniform(const BodySetDescription &set, SveBodyStore &bodies, size_t begin, size_t end, ScenarioRng &rng) {
+    const float bodyMass = set.mass / set.count;
+    for (size_t i = begin; i < end; i++) {
+        bodies.positionX[i] = set.center.x + (rng.uniform() - 0.5f) * set.size.x;
+        bodies.positionY[i] = set.center.y + (rng.uniform() - 0.5f) * set.size.y;
+        bodies.velocityX[i] = set.velocity.x;
+        bodies.velocityY[i] = set.velocity.y;
+        bodies.mass[i] = bodyMass;
+    }
+}
+
+// random unit vector in 3d, only the part in the plane is returned
+static glm::vec2 randomDirectionInPlane(ScenarioRng &rng) {
+    float z = 2.f * rng.uniform() - 1.f;
+    float phi = glm::two_pi<float>() * rng.uniform();
+    float r = std::sqrt(1.f - z * z);
+    return {r * std::cos(phi), r * std::sin(phi)};
+}
+
+// Aarseth, Henon and Wielen (1974): radii from the inverted cumulative mass, speeds by rejection
+// from the distribution function, both in units of the escape speed
+static void fillPlummer(
+    const BodySetDescription &set, float strength, SveBodyStore &bodies, size_t begin, size_t end, ScenarioRng &rng) {
+    const float bodyMass = set.mass / set.count;
+    const float a = set.scale;
+    for (size_t i = begin; i < end; i++) {
+        // the tail is cut at 10 scale radii, past that there are few bodies and they are barely bound
+        float r;
+        do {
+            r = a / std::sqrt(std::pow(rng.uniformOpen(), -2.f / 3.f) - 1.f);
+        } while (!(r < 10.f * a));
+
+        float q;
+        float g;
+        do {
+            q = rng.uniform();
+            g = 0.1f * rng.uniform();
+        } while (g > q * q * std::pow(1.f - q * q, 3.5f));
+        float escapeSpeed = std::sqrt(2.f * strength * set.mass) * std::pow(r * r + a * a, -0.25f);
+
+        glm::vec2 position = set.center + r * randomDirectionInPlane(rng);
+        glm::vec2 velocity = set.velocity + q * escapeSpeed * randomDirectionInPlane(rng);
+        bodies.positionX[i] = position.x;
+        bodies.positionY[i] = position.y;
+        bodies.velocityX[i] = velocity.x;
+        bodies.velocityY[i] = velocity.y;
+        bodies.mass[i] = bodyMass;
+    }
+}
+
+// Surface density exp(-R / Rd). R follows a gamma(2) distribution, the sum of two exponentials,
+// and speeds are circular for the mass inside R as if it were spherical
+static void fillDisk(
+    const BodySetDescription &set, float strength, SveBodyStore &bodies, size_t begin, size_t end, ScenarioRng &rng) {
+    const float bodyMass = set.mass / set.count;
+    const float rd = set.scale;
+    for (size_t i = begin; i < end; i++) {
+        float radius;
+        do {
+            radius = -rd * std::log(rng.uniformOpen() * rng.uniformOpen());
+        } while (!(radius < 10.f * rd) || radius <= 0.f);
+
+        float x = radius / rd;
+        float enclosed = set.mass * (1.f - (1.f + x) * std::exp(-x));
+        float speed = std::sqrt(strength * enclosed / radius);
+
+        float phi = glm::two_pi<float>() * rng.uniform();
+        glm::vec2 direction{std::cos(phi), std::sin(phi)};
+        glm::vec2 position = set.center + radius * direction;
+        glm::vec2 velocity = set.velocity + speed * glm::vec2{-direction.y, direction.x};
+        bodies.positionX[i] = position.x;
+        bodies.positionY[i] = position.y;
+        bodies.velocityX[i] = velocity.x;
+        bodies.velocityY[i] = velocity.y;
+        bodies.mass[i] = bodyMass;
+    }
+}
+
+void Scenario::generateBodies(SveThreadPool &pool, SveBodyStore &bodies) const {
+    // snapshot sets are read up front, their size is only known once loaded
+    std::vector<SveBodyStore> snapshots(bodySets.size());
+    size_t total = 0;
+    for (size_t s = 0; s < bodySets.size(); s++) {
+        if (bodySets[s].kind == BodySetKind::Snapshot) {
+            readSnapshot(bodySets[s].path, snapshots[s]);
+            total += snapshots[s].size();
+        } else {
+            total += bodySets[s].kind == BodySetKind::Body ? 1 : bodySets[s].count;
+        }
+    }
+
+    bodies.clear();
+    bodies.resize(total);  // ids come out as the index
+
+    size_t offset = 0;
+    for (size_t s = 0; s < bodySets.size(); s++) {
+        const BodySetDescription &set = bodySets[s];
+
+        if (set.kind == BodySetKind::Snapshot) {
+            const SveBodyStore &snapshot = snapshots[s];
+            for (size_t i = 0; i < snapshot.size(); i++) {
+                bodies.positionX[offset + i] = snapshot.positionX[i] + set.center.x;
+                bodies.positionY[offset + i] = snapshot.positionY[i] + set.center.y;
+                bodies.velocityX[offset + i] = snapshot.velocityX[i] + set.velocity.x;
+                bodies.velocityY[offset + i] = snapshot.velocityY[i] + set.velocity.y;
+                bodies.mass[offset + i] = snapshot.mass[i];
+            }
+            offset += snapshot.size();
+            continue;
+        }
+
+        const size_t count = set.kind == BodySetKind::Body ? 1 : set.count;
+        pool.parallelFor(count, GENERATOR_CHUNK, [&](size_t begin, size_t end, unsigned int) {
+            // the pool runs small jobs as one range, so ranges are cut back into chunks here. Every
+            // chunk seeds its own stream, the result is the same however the work was split
+            for (size_t chunk = begin; chunk < end; chunk += GENERATOR_CHUNK) {
+                const size_t chunkEnd = std::min(chunk + GENERATOR_CHUNK, end);
+                ScenarioRng seeder{set.seed * 0x9e3779b97f4a7c15ull + chunk / GENERATOR_CHUNK};
+                ScenarioRng rng{seeder.next()};
+                switch (set.kind) {
+                    case BodySetKind::Body:
+                        fillBody(set, bodies, offset + chunk, offset + chunkEnd, rng);
+                        break;
+                    case BodySetKind::Uniform:
+                        fillUniform(set, bodies, offset + chunk, offset + chunkEnd, rng);
+                        break;
+                    case BodySetKind::Plummer:
+                        fillPlummer(set, strength, bodies, offset + chunk, offset + chunkEnd, rng);
+                        break;
+                    case BodySetKind::Disk:
+                        fillDisk(set, strength, bodies, offset + chunk, offset + chunkEnd, rng);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        });
+        offset += count;
+    }
+}
+
+void Scenario::configure(GravityPhysicsSystem &system) const {
+    system.solver = solver;
+    system.integrator = integrator;
+    system.openingAngle = openingAngle;
+    system.meshSize = meshSize;
+    system.timestepAccuracy = timestepAccuracy;
+    system.maxTimestepLevel = maxTimestepLevel;
+    system.invalidateForces();
+}
+
+void Scenario::createFieldSamples(Vec2FieldSamples &field) const {
+    const int gridCount = static_cast<int>(fieldGrid);
+    for (int i = 0; i < gridCount; i++) {
+        for (int j = 0; j < gridCount; j++) {
+            field.addSample({-1.0f + (i + 0.5f) * 2.0f / gridCount, -1.0f + (j + 0.5f) * 2.0f / gridCount});
+        }
+    }
+}
+
+// parsing
+
+static float parseFloat(const std::string &text) {
+    size_t used = 0;
+    float value = std::stof(text, &used);
+    if (used != text.size()) throw std::invalid_argument(text);
+    return value;
+}
+
+static unsigned long long parseUnsigned(const std::string &text) {
+    size_t used = 0;
+    if (!text.empty() && text[0] == '-') throw std::invalid_argument(text);
+    unsigned long long value = std::stoull(text, &used);
+    if (used != text.size()) throw std::invalid_argument(text);
+    return value;
+}
+
+static glm::vec2 parseVec2(const std::string &text) {
+    size_t comma = text.find(',');
+    if (comma == std::string::npos) throw std::invalid_argument(text);
+    return {parseFloat(text.substr(0, comma)), parseFloat(text.substr(comma + 1))};
+}
+
+static ForceSolver parseSolver(const std::string &text) {
+    if (text == "direct") return ForceSolver::DirectSum;
+    if (text == "direct_tiled") return ForceSolver::DirectSumTiled;
+    if (text == "direct_simd") return ForceSolver::DirectSumSimd;
+    if (text == "barnes_hut") return ForceSolver::BarnesHut;
+    if (text == "particle_mesh") return ForceSolver::ParticleMesh;
+    throw std::invalid_argument(text);
+}
+
+static Integrator parseIntegrator(const std::string &text) {
+    if (text == "euler") return Integrator::SemiImplicitEuler;
+    if (text == "leapfrog") return Integrator::Leapfrog;
+    if (text == "yoshida4") return Integrator::Yoshida4;
+    if (text == "block") return Integrator::BlockTimestep;
+    throw std::invalid_argument(text);
+}
+
+static BodySetDescription parseBodySet(std::istringstream &words) {
+    BodySetDescription set{};
+    std::string kind;
+    words >> kind;
+    if (kind == "body") {
+        set.kind = BodySetKind::Body;
+    } else if (kind == "uniform") {
+        set.kind = BodySetKind::Uniform;
+    } else if (kind == "plummer") {
+        set.kind = BodySetKind::Plummer;
+    } else if (kind == "disk") {
+        set.kind = BodySetKind::Disk;
+    } else if (kind == "snapshot") {
+        set.kind = BodySetKind::Snapshot;
+    } else {
+        throw std::invalid_argument("unknown body set " + kind);
+    }
+
+    std::string word;
+    while (words >> word) {
+        size_t equals = word.find('=');
+        if (equals == std::string::npos) throw std::invalid_argument("expected key=value, got " + word);
+        std::string key = word.substr(0, equals);
+        std::string value = word.substr(equals + 1);
+        if (key == "count") {
+            set.count = static_cast<size_t>(parseUnsigned(value));
+        } else if (key == "mass") {
+            set.mass = parseFloat(value);
+        } else if (key == "center") {
+            set.center = parseVec2(value);
+        } else if (key == "velocity") {
+            set.velocity = parseVec2(value);
+        } else if (key == "size") {
+            set.size = parseVec2(value);
+        } else if (key == "scale") {
+            set.scale = parseFloat(value);
+        } else if (key == "seed") {
+            set.seed = parseUnsigned(value);
+        } else if (key == "path") {
+            set.path = value;
+        } else {
+            throw std::invalid_argument("unknown body set key " + key);
+        }
+    }
+
+    if (set.kind == BodySetKind::Snapshot && set.path.empty()) {
+        throw std::invalid_argument("snapshot body set needs a path");
+    }
+    if ((set.kind == BodySetKind::Plummer || set.kind == BodySetKind::Disk) && !(set.scale > 0.f)) {
+        throw std::invalid_argument("scale has to be positive");
+    }
+    return set;
+}
+
+Scenario Scenario::load(const std::string &path) {
+    std::ifstream file{path};
+    if (!file) {
+        throw std::runtime_error("failed to open scenario: " + path);
+    }
+
+    Scenario scenario{};
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream words{line};
+        std::string key;
+        if (!(words >> key)) continue;
+
+        try {
+            std::string value;
+            if (key == "bodies") {
+                scenario.bodySets.push_back(parseBodySet(words));
+                continue;
+            }
+            if (!(words >> value)) throw std::invalid_argument("missing value");
+
+            if (key == "strength") {
+                scenario.strength = parseFloat(value);
+            } else if (key == "solver") {
+                scenario.solver = parseSolver(value);
+            } else if (key == "integrator") {
+                scenario.integrator = parseIntegrator(value);
+            } else if (key == "opening_angle") {
+                scenario.openingAngle = parseFloat(value);
+            } else if (key == "mesh_size") {
+                scenario.meshSize = static_cast<unsigned int>(parseUnsigned(value));
+                // ParticleMesh only asserts this, and release builds would run on with wrong forces
+                if (scenario.meshSize < 8 || (scenario.meshSize & (scenario.meshSize - 1)) != 0) {
+                    throw std::invalid_argument("mesh_size has to be a power of two of at least 8");
+                }
+            } else if (key == "timestep_accuracy") {
+                scenario.timestepAccuracy = parseFloat(value);
+            } else if (key == "max_timestep_level") {
+                scenario.maxTimestepLevel = static_cast<unsigned int>(parseUnsigned(value));
+                if (scenario.maxTimestepLevel > GravityPhysicsSystem::MAX_TIMESTEP_LEVEL) {
+                    throw std::invalid_argument(
+                        "max_timestep_level can be at most " + std::to_string(GravityPhysicsSystem::MAX_TIMESTEP_LEVEL));
+                }
+            } else if (key == "threads") {
+                scenario.threadCount = static_cast<unsigned int>(parseUnsigned(value));
+            } else if (key == "tick") {
+                scenario.tickDelta = parseFloat(value);
+            } else if (key == "substeps") {
+                scenario.substeps = static_cast<unsigned int>(parseUnsigned(value));
+            } else if (key == "field_grid") {
+                scenario.fieldGrid = static_cast<unsigned int>(parseUnsigned(value));
+            } else {
+                throw std::invalid_argument("unknown setting " + key);
+            }
+
+            std::string extra;
+            if (words >> extra) throw std::invalid_argument("unexpected " + extra);
+        } catch (const std::logic_error &e) {
+            // stof and friends throw invalid_argument or out_of_range with unhelpful messages
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": bad line '" + line + "' (" + e.what() + ")");
+        }
+    }
+
+    if (scenario.substeps == 0 || !(scenario.tickDelta > 0.f)) {
+        throw std::runtime_error(path + ": tick and substeps have to be positive");
+    }
+    return scenario;
+}
+
+}  // namespace sve
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gravity_physics_system.hpp"
+#include "sve_body_store.hpp"
+#include "sve_thread_pool.hpp"
+#include "vec2_field_system.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sve {
+
+enum class BodySetKind {
+    Body,      // a single body
+    Uniform,   // bodies at rest spread evenly over a box
+    Plummer,   // plummer sphere seen from above, in virial equilibrium for a 3d 1/r^2 law
+    Disk,      // exponential disk on circular orbits
+    Snapshot,  // the bodies of a snapshot file
+};
+
+struct BodySetDescription {
+    BodySetKind kind{BodySetKind::Uniform};
+    size_t count{1};
+    float mass{1.f};             // total mass of the set, shared evenly. The mass of the body for Body
+    glm::vec2 center{0.f};       // Body position, the set is moved here
+    glm::vec2 velocity{0.f};     // added to every body of the set
+    glm::vec2 size{2.f};         // Uniform box size
+    float scale{0.2f};           // Plummer radius or Disk scale length
+    uint64_t seed{1};
+    std::string path{};          // Snapshot file
+};
+
+// Everything needed to set up a run: the bodies, the field grid and the physics constants.
+//
+// Scenario files have one setting per line, # starts a comment:
+//
+//   strength 0.81
+//   solver barnes_hut            direct, direct_tiled, direct_simd, barnes_hut or particle_mesh
+//   integrator leapfrog          euler, leapfrog, yoshida4 or block
+//   opening_angle 0.5
+//   mesh_size 256
+//   timestep_accuracy 0.001
+//   max_timestep_level 6
+//   threads 0
+//   tick 0.0166667
+//   substeps 2
+//   field_grid 40
+//   bodies plummer count=1000000 mass=1 scale=0.2 center=0,0 velocity=0,0 seed=1
+//   bodies disk count=1000000 mass=1 scale=0.2
+//   bodies uniform count=1000 mass=1 size=2,2
+//   bodies body center=0.5,0.5 velocity=-0.5,0 mass=1
+//   bodies snapshot path=states/two_body.snap center=0,0
+//
+// Every bodies line adds a set, ids are handed out in file order.
+struct Scenario {
+    float strength{0.81f};
+    ForceSolver solver{ForceSolver::DirectSum};
+    Integrator integrator{Integrator::Leapfrog};
+    float openingAngle{0.5f};
+    unsigned int meshSize{256};
+    float timestepAccuracy{0.001f};
+    unsigned int maxTimestepLevel{6};
+    unsigned int threadCount{0};
+    float tickDelta{1.f / 60};
+    unsigned int substeps{2};
+    unsigned int fieldGrid{40};  // field samples per axis over [-1, 1]^2, 0 for no field
+    std::vector<BodySetDescription> bodySets;
+
+    // throws std::runtime_error naming the file and line of the first problem
+    static Scenario load(const std::string &path);
+
+    // copies the tunable settings into a system built with strength and threadCount
+    void configure(GravityPhysicsSystem &system) const;
+
+    // Fills bodies with every set, replacing what was there. Large sets are generated in parallel
+    // on pool, each chunk with its own random stream so the result does not depend on thread count
+    void generateBodies(SveThreadPool &pool, SveBodyStore &bodies) const;
+
+    void createFieldSamples(Vec2FieldSamples &field) const;
+};
+
+}  // namespace sve
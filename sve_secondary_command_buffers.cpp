@@ -0,0 +1,167 @@
+#include "sve_secondary_command_buffers.hpp"
+
+#include "sve_swap_chain.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace sve {
+
+SveSecondaryCommandBuffers::SveSecondaryCommandBuffers(SveDevice &device)
+    : sveDevice{device}, framePools(SveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.subpass = 0;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = sveDevice.findPhysicalQueueFamilies().graphicsFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(sveDevice.device(), &poolInfo, nullptr, &cachedPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+}
+
+SveSecondaryCommandBuffers::~SveSecondaryCommandBuffers() {
+    // destroying a pool frees its buffers
+    vkDestroyCommandPool(sveDevice.device(), cachedPool, nullptr);
+    for (auto &pools : framePools) {
+        for (auto &worker : pools) {
+            vkDestroyCommandPool(sveDevice.device(), worker.pool, nullptr);
+        }
+    }
+}
+
+void SveSecondaryCommandBuffers::beginFrame(int frameIndex) {
+    this->frameIndex = frameIndex;
+    for (auto &worker : framePools[frameIndex]) {
+        vkResetCommandPool(sveDevice.device(), worker.pool, 0);
+        worker.used = 0;
+    }
+}
+
+void SveSecondaryCommandBuffers::beginRenderPass(
+    unsigned int workerCount, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+    // pools for new workers are made for every frame at once, the vectors must not change size while
+    // workers are recording
+    if (framePools[0].size() < workerCount) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = sveDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (auto &pools : framePools) {
+            while (pools.size() < workerCount) {
+                WorkerPool worker{};
+                if (vkCreateCommandPool(sveDevice.device(), &poolInfo, nullptr, &worker.pool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create command pool!");
+                }
+                pools.push_back(std::move(worker));
+            }
+        }
+    }
+
+    inheritance.renderPass = renderPass;
+    inheritance.framebuffer = framebuffer;
+    this->extent = extent;
+}
+
+VkCommandBuffer SveSecondaryCommandBuffers::begin(unsigned int workerIndex) {
+    assert(workerIndex < framePools[frameIndex].size() && "render pass was begun for fewer workers");
+    WorkerPool &worker = framePools[frameIndex][workerIndex];
+
+    if (worker.used == worker.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = worker.pool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(sveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+        worker.buffers.push_back(commandBuffer);
+    }
+    VkCommandBuffer commandBuffer = worker.buffers[worker.used++];
+    beginInheriting(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, inheritance.framebuffer);
+    return commandBuffer;
+}
+
+void SveSecondaryCommandBuffers::beginInheriting(
+    VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags, VkFramebuffer framebuffer) {
+    VkCommandBufferInheritanceInfo inheritanceInfo = inheritance;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{{0, 0}, extent};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void SveSecondaryCommandBuffers::end(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+uint32_t SveSecondaryCommandBuffers::createCached() {
+    cachedBuffers.emplace_back(SveSwapChain::MAX_FRAMES_IN_FLIGHT);
+    return static_cast<uint32_t>(cachedBuffers.size() - 1);
+}
+
+VkCommandBuffer SveSecondaryCommandBuffers::getCached(uint32_t id) const {
+    const CachedBuffer &cached = cachedBuffers[id][frameIndex];
+    bool compatible = cached.renderPass != VK_NULL_HANDLE && cached.renderPass == inheritance.renderPass &&
+                      cached.extent.width == extent.width && cached.extent.height == extent.height;
+    return compatible ? cached.buffer : VK_NULL_HANDLE;
+}
+
+VkCommandBuffer SveSecondaryCommandBuffers::beginCached(uint32_t id) {
+    CachedBuffer &cached = cachedBuffers[id][frameIndex];
+    if (cached.buffer == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = cachedPool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(sveDevice.device(), &allocInfo, &cached.buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+    }
+
+    // the frame's fence has signaled, the primary that last ran this buffer is done with it. Only
+    // that primary ran it, so it needs no simultaneous use
+    beginInheriting(cached.buffer, 0, VK_NULL_HANDLE);
+    cached.renderPass = inheritance.renderPass;
+    cached.extent = extent;
+    return cached.buffer;
+}
+
+void SveSecondaryCommandBuffers::invalidateCached(uint32_t id) {
+    cachedBuffers[id][frameIndex].renderPass = VK_NULL_HANDLE;
+}
+
+void SveSecondaryCommandBuffers::invalidateAllCached() {
+    // a recreated render pass can come back with the handle of the destroyed one, comparing
+    // handles alone would not notice
+    for (auto &frames : cachedBuffers) {
+        for (auto &cached : frames) {
+            cached.renderPass = VK_NULL_HANDLE;
+        }
+    }
+}
+
+}  // namespace sve
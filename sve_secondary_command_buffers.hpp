@@ -0,0 +1,74 @@
+#pragma once
+
+#include "sve_device.hpp"
+
+// std
+#include <vector>
+
+namespace sve {
+
+// Secondary command buffers that continue the swap chain render pass, so several threads can record
+// its draws at once. Command pools are externally synchronized, every worker gets a pool of its own
+// for each frame in flight. A frame's pools are reset as a whole once its fence has signaled, buffers
+// are kept and reused rather than freed.
+class SveSecondaryCommandBuffers {
+   public:
+    explicit SveSecondaryCommandBuffers(SveDevice &device);
+    ~SveSecondaryCommandBuffers();
+
+    SveSecondaryCommandBuffers(const SveSecondaryCommandBuffers &) = delete;
+    SveSecondaryCommandBuffers &operator=(const SveSecondaryCommandBuffers &) = delete;
+
+    // SveRenderer calls these, beginFrame after the frame's fence wait and beginRenderPass when it
+    // begins the swap chain render pass for secondary command buffers
+    void beginFrame(int frameIndex);
+    void beginRenderPass(unsigned int workerCount, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+    // Starts recording a buffer from workerIndex's pool with viewport and scissor already set, dynamic
+    // state is not inherited from the primary. Safe to call from several threads at once as long as
+    // each uses its own workerIndex, below the count the render pass was begun with
+    VkCommandBuffer begin(unsigned int workerIndex);
+    void end(VkCommandBuffer commandBuffer);
+
+    // Buffers that are recorded once and run again every frame until invalidated, for draws that
+    // rarely change. Each id has one per frame in flight. They are recorded without a framebuffer,
+    // so they run in any framebuffer of a compatible render pass, and are only reused while the render
+    // pass and extent they were recorded for are the current ones. Main thread only
+    uint32_t createCached();
+    // id's buffer for the current frame, VK_NULL_HANDLE when it has to be recorded with beginCached
+    VkCommandBuffer getCached(uint32_t id) const;
+    // records id's buffer for the current frame again, finish it with end
+    VkCommandBuffer beginCached(uint32_t id);
+    // the current frame's buffer of id, the other frames' are still run by their pending primaries
+    void invalidateCached(uint32_t id);
+    // every cached buffer, SveRenderer calls this when it recreates the swap chain
+    void invalidateAllCached();
+
+   private:
+    struct WorkerPool {
+        VkCommandPool pool{VK_NULL_HANDLE};
+        std::vector<VkCommandBuffer> buffers;
+        size_t used{0};
+    };
+
+    struct CachedBuffer {
+        VkCommandBuffer buffer{VK_NULL_HANDLE};
+        VkRenderPass renderPass{VK_NULL_HANDLE};  // recorded for, null while it needs recording
+        VkExtent2D extent{};
+    };
+
+    void beginInheriting(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags, VkFramebuffer framebuffer);
+
+    SveDevice &sveDevice;
+    std::vector<std::vector<WorkerPool>> framePools;  // per frame in flight, then per worker
+    int frameIndex{0};
+
+    // buffers are reset one at a time when re-recorded, never as a pool
+    VkCommandPool cachedPool;
+    std::vector<std::vector<CachedBuffer>> cachedBuffers;  // per id, then per frame in flight
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    VkExtent2D extent{};
+};
+
+}  // namespace sve
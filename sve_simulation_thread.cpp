@@ -0,0 +1,99 @@
+#include "sve_simulation_thread.hpp"
+
+#include "sve_profiler.hpp"
+
+// std
+#include <algorithm>
+
+namespace sve {
+
+SveSimulationThread::SveSimulationThread(
+    GravityPhysicsSystem &gravitySystem,
+    Vec2FieldSystem &fieldSystem,
+    SveBodyStore &bodies,
+    Vec2FieldSamples &fieldSamples,
+    float tickDelta,
+    unsigned int substeps)
+    : gravitySystem{gravitySystem},
+      fieldSystem{fieldSystem},
+      bodies{bodies},
+      fieldSamples{fieldSamples},
+      timestep{tickDelta},
+      substeps{substeps} {
+    // the starting state goes out before the thread runs so there is always something to draw
+    previousPositions.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        previousPositions[i] = bodies.position(i);
+    }
+    fieldSystem.update(gravitySystem, bodies, fieldSamples);
+    publish(std::chrono::steady_clock::now(), 0);
+
+    thread = std::thread{&SveSimulationThread::run, this};
+}
+
+SveSimulationThread::~SveSimulationThread() {
+    stopping = true;
+    thread.join();
+}
+
+float SveSimulationThread::interpolationAlpha(
+    const SimulationSnapshot &snapshot, std::chrono::steady_clock::time_point now) const {
+    float behind = std::chrono::duration<float, std::chrono::seconds::period>(now - snapshot.time).count();
+    return glm::clamp(behind / timestep.getTickDelta(), 0.f, 1.f);
+}
+
+void SveSimulationThread::run() {
+    SVE_PROFILE_THREAD("simulation");
+    auto currentTime = std::chrono::steady_clock::now();
+    uint64_t tick = 0;
+
+    while (!stopping) {
+        auto newTime = std::chrono::steady_clock::now();
+        float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+        currentTime = newTime;
+
+        unsigned int ticks = timestep.advance(frameTime);
+        for (unsigned int i = 0; i < ticks; i++) {
+            for (size_t b = 0; b < bodies.size(); b++) {
+                previousPositions[b] = bodies.position(b);
+            }
+            {
+                SVE_PROFILE_SCOPE("GravityPhysicsSystem::update");
+                gravitySystem.update(bodies, timestep.getTickDelta(), substeps);
+            }
+            tick++;
+        }
+
+        if (ticks > 0) {
+            {
+                SVE_PROFILE_SCOPE("Vec2FieldSystem::update");
+                fieldSystem.update(gravitySystem, bodies, fieldSamples);
+            }
+
+            // the time left in the accumulator has not been simulated yet
+            auto stateTime = currentTime - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                               std::chrono::duration<float>(timestep.getAlpha() * timestep.getTickDelta()));
+            SVE_PROFILE_SCOPE("publish");
+            publish(stateTime, tick);
+        }
+
+        // sleep until the next tick is due instead of spinning on the clock
+        std::this_thread::sleep_for(std::chrono::duration<float>((1.f - timestep.getAlpha()) * timestep.getTickDelta()));
+    }
+}
+
+void SveSimulationThread::publish(std::chrono::steady_clock::time_point stateTime, uint64_t tick) {
+    SimulationSnapshot &snapshot = snapshots.writeSlot();
+    snapshot.previousPositions = previousPositions;
+    snapshot.positions.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        snapshot.positions[i] = bodies.position(i);
+    }
+    snapshot.fieldScale = fieldSamples.scale;
+    snapshot.fieldRotation = fieldSamples.rotation;
+    snapshot.time = stateTime;
+    snapshot.tick = tick;
+    snapshots.publish();
+}
+
+}  // namespace sve
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "gravity_physics_system.hpp"
+#include "sve_body_store.hpp"
+#include "sve_fixed_timestep.hpp"
+#include "sve_triple_buffer.hpp"
+#include "vec2_field_system.hpp"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace sve {
+
+// What the simulation thread hands to the renderer after every batch of ticks, only the data
+// drawing needs
+struct SimulationSnapshot {
+    std::vector<glm::vec2> previousPositions;  // bodies one tick before positions
+    std::vector<glm::vec2> positions;
+    std::vector<float> fieldScale;
+    std::vector<float> fieldRotation;
+
+    // real time the simulated state in positions belongs to
+    std::chrono::steady_clock::time_point time{};
+    uint64_t tick{0};
+};
+
+// Runs the physics and field systems on their own thread at a fixed tick rate, so the next state is
+// simulated while the render thread records and presents the current one. Completed states are
+// published through a triple buffer. The systems and stores passed in belong to this thread until
+// it is destroyed, the render thread should only read snapshots.
+class SveSimulationThread {
+   public:
+    SveSimulationThread(
+        GravityPhysicsSystem &gravitySystem,
+        Vec2FieldSystem &fieldSystem,
+        SveBodyStore &bodies,
+        Vec2FieldSamples &fieldSamples,
+        float tickDelta,
+        unsigned int substeps);
+    ~SveSimulationThread();
+
+    SveSimulationThread(const SveSimulationThread &) = delete;
+    SveSimulationThread &operator=(const SveSimulationThread &) = delete;
+
+    // newest completed state, stays valid until the next call
+    const SimulationSnapshot &latest() {
+        snapshots.acquire();
+        return snapshots.readSlot();
+    }
+
+    // how far between previousPositions and positions to draw a snapshot at a given time, states
+    // are shown one tick late so there is always a newer one to blend towards
+    float interpolationAlpha(const SimulationSnapshot &snapshot, std::chrono::steady_clock::time_point now) const;
+
+   private:
+    void run();
+    void publish(std::chrono::steady_clock::time_point stateTime, uint64_t tick);
+
+    GravityPhysicsSystem &gravitySystem;
+    Vec2FieldSystem &fieldSystem;
+    SveBodyStore &bodies;
+    Vec2FieldSamples &fieldSamples;
+    SveFixedTimestep timestep;
+    const unsigned int substeps;
+
+    std::vector<glm::vec2> previousPositions;
+    SveTripleBuffer<SimulationSnapshot> snapshots;
+
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+}  // namespace sve
@@ -0,0 +1,193 @@
+#include "sve_snapshot.hpp"
+
+// std
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace sve {
+
+static constexpr char SNAPSHOT_MAGIC[8] = {'S', 'V', 'E', 'S', 'N', 'A', 'P', '\0'};
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+static constexpr int SNAPSHOT_ARRAYS = 6;
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// byte offset of every array in the file, plus the total file size as the last entry
+static void arrayOffsets(uint64_t bodyCount, uint64_t offsets[SNAPSHOT_ARRAYS + 1]) {
+    uint64_t offset = alignUp(sizeof(SnapshotHeader));
+    for (int a = 0; a < SNAPSHOT_ARRAYS; a++) {
+        offsets[a] = offset;
+        offset = alignUp(offset + bodyCount * 4);  // every array holds 4 byte values
+    }
+    offsets[SNAPSHOT_ARRAYS] = offset;
+}
+
+static std::runtime_error snapshotError(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + ": " + path + " (" + std::strerror(errno) + ")");
+}
+
+// closes fd when it is open and removes the half written file, keeping errno for the error message
+static void discardTemp(int fd, const std::string &tempPath) {
+    const int error = errno;
+    if (fd >= 0) close(fd);
+    unlink(tempPath.c_str());
+    errno = error;
+}
+
+void writeSnapshot(const std::string &path, const SveBodyStore &bodies, double time) {
+    static_assert(sizeof(float) == 4 && sizeof(uint32_t) == 4, "snapshot arrays are 4 byte values");
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.bodyCount = bodies.size();
+    header.time = time;
+
+    uint64_t offsets[SNAPSHOT_ARRAYS + 1];
+    arrayOffsets(header.bodyCount, offsets);
+    const void *arrays[SNAPSHOT_ARRAYS] = {
+        bodies.positionX.data(),
+        bodies.positionY.data(),
+        bodies.velocityX.data(),
+        bodies.velocityY.data(),
+        bodies.mass.data(),
+        bodies.id.data()};
+
+    // the gaps between arrays are filled from a block of zeros, so the whole file goes out in one
+    // writev straight from the store without staging it in a buffer first
+    static const char padding[SNAPSHOT_ALIGNMENT] = {};
+    iovec parts[2 * SNAPSHOT_ARRAYS + 2];
+    int partCount = 0;
+    parts[partCount++] = {&header, sizeof(header)};
+    parts[partCount++] = {const_cast<char *>(padding), offsets[0] - sizeof(header)};
+    for (int a = 0; a < SNAPSHOT_ARRAYS; a++) {
+        const uint64_t bytes = header.bodyCount * 4;
+        parts[partCount++] = {const_cast<void *>(arrays[a]), bytes};
+        parts[partCount++] = {const_cast<char *>(padding), offsets[a + 1] - offsets[a] - bytes};
+    }
+
+    // the new snapshot is written next to the old one and renamed over it once it is on disk, a crash
+    // in the middle of a checkpoint leaves the previous one to resume from
+    const std::string tempPath = path + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw snapshotError("failed to open snapshot for writing", tempPath);
+
+    // writev may stop short for very large files, carry on from wherever it got to
+    const uint64_t total = offsets[SNAPSHOT_ARRAYS];
+    uint64_t written = 0;
+    iovec *next = parts;
+    while (written < total) {
+        ssize_t result = writev(fd, next, static_cast<int>(parts + partCount - next));
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            discardTemp(fd, tempPath);
+            throw snapshotError("failed to write snapshot", tempPath);
+        }
+        written += static_cast<uint64_t>(result);
+        size_t remaining = static_cast<size_t>(result);
+        while (next < parts + partCount && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            next++;
+        }
+        if (remaining > 0) {
+            next->iov_base = static_cast<char *>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+
+    if (fsync(fd) != 0) {
+        discardTemp(fd, tempPath);
+        throw snapshotError("failed to sync snapshot", tempPath);
+    }
+    if (close(fd) != 0) {
+        discardTemp(-1, tempPath);
+        throw snapshotError("failed to write snapshot", tempPath);
+    }
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        discardTemp(-1, tempPath);
+        throw snapshotError("failed to replace snapshot", path);
+    }
+
+    // the rename only survives a crash once the directory entry is on disk too
+    const size_t slash = path.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (directoryFd < 0) throw snapshotError("failed to open snapshot directory", directory);
+    if (fsync(directoryFd) != 0) {
+        close(directoryFd);
+        throw snapshotError("failed to sync snapshot directory", directory);
+    }
+    close(directoryFd);
+}
+
+double readSnapshot(const std::string &path, SveBodyStore &bodies) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw snapshotError("failed to open snapshot", path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw snapshotError("failed to stat snapshot", path);
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+    if (fileSize < sizeof(SnapshotHeader)) {
+        close(fd);
+        throw std::runtime_error("snapshot is truncated: " + path);
+    }
+
+    void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) throw snapshotError("failed to map snapshot", path);
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+
+    const char *bytes = static_cast<const char *>(mapping);
+    SnapshotHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    const char *problem = nullptr;
+    uint64_t offsets[SNAPSHOT_ARRAYS + 1];
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a snapshot file: ";
+    } else if (header.byteOrderMark != BYTE_ORDER_MARK) {
+        problem = "snapshot was written with a different byte order: ";
+    } else if (header.version != SNAPSHOT_VERSION) {
+        problem = "unsupported snapshot version: ";
+    } else if (header.bodyCount > fileSize / 4) {
+        problem = "snapshot is truncated: ";
+    } else {
+        arrayOffsets(header.bodyCount, offsets);
+        if (offsets[SNAPSHOT_ARRAYS] > fileSize) problem = "snapshot is truncated: ";
+    }
+    if (problem != nullptr) {
+        munmap(mapping, fileSize);
+        throw std::runtime_error(problem + path);
+    }
+
+    // every array is a straight copy out of the mapping, the pages are only touched once
+    const size_t count = static_cast<size_t>(header.bodyCount);
+    auto floats = [&](int a) { return reinterpret_cast<const float *>(bytes + offsets[a]); };
+    bodies.positionX.assign(floats(0), floats(0) + count);
+    bodies.positionY.assign(floats(1), floats(1) + count);
+    bodies.velocityX.assign(floats(2), floats(2) + count);
+    bodies.velocityY.assign(floats(3), floats(3) + count);
+    bodies.mass.assign(floats(4), floats(4) + count);
+    const uint32_t *ids = reinterpret_cast<const uint32_t *>(bytes + offsets[5]);
+    bodies.id.assign(ids, ids + count);
+
+    munmap(mapping, fileSize);
+    return header.time;
+}
+
+}  // namespace sve
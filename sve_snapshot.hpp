@@ -0,0 +1,38 @@
+#pragma once
+
+#include "sve_body_store.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace sve {
+
+// Binary checkpoint of the body state, laid out so it can be written with one gathered write and
+// loaded by mapping the file and copying each array out whole, there is nothing to parse.
+//
+// The file is this header followed by positionX, positionY, velocityX, velocityY, mass (float) and
+// id (uint32), bodyCount of each, every array starting on a SNAPSHOT_ALIGNMENT boundary. Values
+// are stored in the byte order of the machine that wrote them, byteOrderMark catches a mismatch.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t bodyCount;
+    double time;  // simulated seconds when the snapshot was taken
+    uint64_t reserved[4];
+};
+
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+static constexpr uint64_t SNAPSHOT_ALIGNMENT = 64;
+
+// Writes to path + ".tmp" and renames it over path once synced, so path always holds either the old
+// or the new snapshot whole. Throws std::runtime_error if the file can't be written, leaving path as
+// it was
+void writeSnapshot(const std::string &path, const SveBodyStore &bodies, double time);
+
+// Replaces the contents of bodies with the snapshot at path and returns its simulation time. Throws
+// std::runtime_error for a missing, truncated or incompatible file
+double readSnapshot(const std::string &path, SveBodyStore &bodies);
+
+}  // namespace sve
@@ -1,5 +1,7 @@
 #include "sve_swap_chain.hpp"
 
+#include "sve_profiler.hpp"
+
 // std
 #include <array>
 #include <cstdlib>
@@ -65,13 +67,17 @@ SveSwapChain::~SveSwapChain() {
 }
 
 VkResult SveSwapChain::acquireNextImage(uint32_t *imageIndex) {
-    vkWaitForFences(
-        device.device(),
-        1,
-        &inFlightFences[currentFrame],
-        VK_TRUE,
-        std::numeric_limits<uint64_t>::max());
+    {
+        SVE_PROFILE_SCOPE("wait inFlightFence");
+        vkWaitForFences(
+            device.device(),
+            1,
+            &inFlightFences[currentFrame],
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
+    }
 
+    SVE_PROFILE_SCOPE("vkAcquireNextImageKHR");
     VkResult result = vkAcquireNextImageKHR(
         device.device(),
         swapChain, std::numeric_limits<uint64_t>::max(),
@@ -84,6 +90,7 @@ VkResult SveSwapChain::acquireNextImage(uint32_t *imageIndex) {
 
 VkResult SveSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) {
     if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+        SVE_PROFILE_SCOPE("wait imageInFlightFence");
         vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
     }
     imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -106,8 +113,11 @@ VkResult SveSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint
 
     vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
 
-    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        SVE_PROFILE_SCOPE("vkQueueSubmit");
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
     }
 
     VkPresentInfoKHR presentInfo{};
@@ -121,7 +131,11 @@ VkResult SveSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = imageIndex;
 
-    VkResult result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+    VkResult result;
+    {
+        SVE_PROFILE_SCOPE("vkQueuePresentKHR");
+        result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+    }
 
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -0,0 +1,83 @@
+#include "sve_thread_pool.hpp"
+
+// std
+#include <algorithm>
+
+namespace sve {
+
+SveThreadPool::SveThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&SveThreadPool::workerLoop, this, i);
+    }
+}
+
+SveThreadPool::~SveThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void SveThreadPool::parallelFor(size_t count, size_t grainSize, const RangeFunction &fn) {
+    if (count == 0) return;
+    grainSize = std::max<size_t>(grainSize, 1);
+    if (workers.empty() || count <= grainSize) {
+        fn(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        job = &fn;
+        jobCount = count;
+        jobGrainSize = grainSize;
+        nextChunk.store(0, std::memory_order_relaxed);
+        busyWorkers = static_cast<unsigned int>(workers.size());
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock{mutex};
+    doneCondition.wait(lock, [&] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void SveThreadPool::workerLoop(unsigned int workerIndex) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        runChunks(workerIndex);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (--busyWorkers == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void SveThreadPool::runChunks(unsigned int workerIndex) {
+    while (true) {
+        size_t begin = nextChunk.fetch_add(jobGrainSize, std::memory_order_relaxed);
+        if (begin >= jobCount) return;
+        (*job)(begin, std::min(begin + jobGrainSize, jobCount), workerIndex);
+    }
+}
+
+}  // namespace sve
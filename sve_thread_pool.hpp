@@ -0,0 +1,56 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sve {
+
+// Fixed set of worker threads that are created once and parked between jobs, so per substep work
+// does not pay for spawning threads.
+class SveThreadPool {
+   public:
+    using RangeFunction = std::function<void(size_t begin, size_t end, unsigned int workerIndex)>;
+
+    // threadCount includes the calling thread, 0 picks one thread per hardware thread
+    explicit SveThreadPool(unsigned int threadCount = 0);
+    ~SveThreadPool();
+
+    SveThreadPool(const SveThreadPool &) = delete;
+    SveThreadPool &operator=(const SveThreadPool &) = delete;
+
+    // number of threads that take part in a parallelFor, worker indices are below this
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    // Splits [0, count) into chunks of grainSize and hands them out to the workers until none are
+    // left, the calling thread works as worker 0. Blocks until every chunk is done. Jobs that fit
+    // in a single chunk run inline. Not reentrant.
+    void parallelFor(size_t count, size_t grainSize, const RangeFunction &fn);
+
+   private:
+    void workerLoop(unsigned int workerIndex);
+    void runChunks(unsigned int workerIndex);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    uint64_t generation{0};
+    unsigned int busyWorkers{0};
+    bool stopping{false};
+
+    // current job, only written while no worker is busy
+    const RangeFunction *job{nullptr};
+    size_t jobCount{0};
+    size_t jobGrainSize{1};
+    std::atomic<size_t> nextChunk{0};
+};
+
+}  // namespace sve
@@ -0,0 +1,106 @@
+#include "sve_trace_writer.hpp"
+
+// std
+#include <stdexcept>
+
+namespace sve {
+
+// large enough that the writer thread issues few syscalls, a frame is a few kilobytes of json
+static constexpr size_t FILE_BUFFER_SIZE = 1 << 20;
+
+SveTraceWriter::SveTraceWriter(const std::string &path, uint64_t originNs) : originNs{originNs} {
+    file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        throw std::runtime_error("failed to open trace file: " + path);
+    }
+    fileBuffer.resize(FILE_BUFFER_SIZE);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", file);
+
+    thread = std::thread{&SveTraceWriter::run, this};
+}
+
+SveTraceWriter::~SveTraceWriter() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    pendingCondition.notify_one();
+    thread.join();
+
+    // track names are metadata events, they may come anywhere in the array
+    for (const auto &[track, name] : trackNames) {
+        std::fprintf(
+            file,
+            "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+            firstEvent ? "" : ",\n",
+            track,
+            name.c_str());
+        firstEvent = false;
+    }
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+}
+
+void SveTraceWriter::write(std::vector<Event> &events) {
+    if (events.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        pending.push_back(std::move(events));
+        if (!spare.empty()) {
+            events = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    events.clear();
+    pendingCondition.notify_one();
+}
+
+void SveTraceWriter::nameTrack(uint32_t track, const std::string &name) {
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto &trackName : trackNames) {
+        if (trackName.first == track) {
+            trackName.second = name;
+            return;
+        }
+    }
+    trackNames.emplace_back(track, name);
+}
+
+void SveTraceWriter::run() {
+    while (true) {
+        std::vector<Event> batch;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            pendingCondition.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;  // only when stopping with nothing left to write
+            batch = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        for (const Event &event : batch) {
+            writeEvent(event);
+        }
+        eventsWritten += batch.size();
+
+        batch.clear();
+        std::lock_guard<std::mutex> lock{mutex};
+        spare.push_back(std::move(batch));
+    }
+}
+
+void SveTraceWriter::writeEvent(const Event &event) {
+    // viewers sort by time themselves, events from different threads go out in the order they were drained
+    uint64_t relativeNs = event.startNs - originNs;
+    std::fprintf(
+        file,
+        "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+        firstEvent ? "" : ",\n",
+        event.name,
+        event.track,
+        relativeNs * 1e-3,
+        event.durationNs * 1e-3);
+    firstEvent = false;
+}
+
+}  // namespace sve
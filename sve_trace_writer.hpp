@@ -0,0 +1,62 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sve {
+
+// Streams timed events to a file in the chrome trace event json format, which chrome://tracing and
+// ui.perfetto.dev load. Events are handed over in batches and formatted and written on a background
+// thread, so the caller only pays for moving a vector.
+class SveTraceWriter {
+   public:
+    struct Event {
+        const char *name;  // string literal
+        uint32_t track;    // one row in the viewer, named with nameTrack
+        uint64_t startNs;  // steady clock, not before originNs
+        uint64_t durationNs;
+    };
+
+    // originNs is time 0 in the trace. Throws std::runtime_error if path can't be opened
+    SveTraceWriter(const std::string &path, uint64_t originNs);
+    // writes out every queued batch and closes the json
+    ~SveTraceWriter();
+
+    SveTraceWriter(const SveTraceWriter &) = delete;
+    SveTraceWriter &operator=(const SveTraceWriter &) = delete;
+
+    // Takes the events and leaves events empty, reusing the capacity of an already written batch
+    // so steady state tracing doesn't allocate
+    void write(std::vector<Event> &events);
+    void nameTrack(uint32_t track, const std::string &name);
+
+    uint64_t getEventsWritten() const { return eventsWritten; }
+
+   private:
+    void run();
+    void writeEvent(const Event &event);
+
+    std::FILE *file;
+    std::vector<char> fileBuffer;
+    const uint64_t originNs;
+    bool firstEvent{true};
+
+    std::mutex mutex;
+    std::condition_variable pendingCondition;
+    std::deque<std::vector<Event>> pending;
+    std::vector<std::vector<Event>> spare;
+    std::vector<std::pair<uint32_t, std::string>> trackNames;
+    bool stopping{false};
+    uint64_t eventsWritten{0};  // only read after the thread is joined
+
+    std::thread thread;
+};
+
+}  // namespace sve
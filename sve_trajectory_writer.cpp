@@ -0,0 +1,300 @@
+#include "sve_trajectory_writer.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace sve {
+
+static constexpr char TRAJECTORY_MAGIC[8] = {'S', 'V', 'E', 'T', 'R', 'A', 'J', '\0'};
+static constexpr float QUANTIZATION_LEVELS = 65535.f;  // 2^QUANTIZATION_BITS - 1
+
+// keyframe boxes are grown by this fraction of their extent on every side, so delta frames keep
+// fitting while the bodies spread out
+static constexpr float KEYFRAME_BOX_MARGIN = 0.25f;
+
+static uint16_t quantize(float value, float boxMin, float scale) {
+    float q = (value - boxMin) * scale + 0.5f;
+    if (!(q >= 0.f)) return 0;  // also catches nan
+    return static_cast<uint16_t>(std::min(q, QUANTIZATION_LEVELS));
+}
+
+static void appendVarint(std::vector<uint8_t> &out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// maps small negative and positive numbers to small unsigned ones, -1 -> 1, 1 -> 2, -2 -> 3, ...
+static uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+SveTrajectoryWriter::SveTrajectoryWriter(
+    const std::string &path, unsigned int keyframeInterval, unsigned int queueCapacity)
+    : keyframeInterval{std::max(1u, keyframeInterval)} {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("failed to open trajectory file: " + path);
+    }
+
+    TrajectoryFileHeader header{};
+    std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.quantizationBits = QUANTIZATION_BITS;
+    writeBytes(&header, sizeof(header));
+
+    frames.resize(std::max(1u, queueCapacity));
+    for (size_t i = 0; i < frames.size(); i++) {
+        freeSlots.push_back(i);
+    }
+
+    thread = std::thread{&SveTrajectoryWriter::run, this};
+}
+
+SveTrajectoryWriter::~SveTrajectoryWriter() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    pendingCondition.notify_one();
+    thread.join();
+    std::fclose(file);
+}
+
+bool SveTrajectoryWriter::record(const SveBodyStore &bodies, uint64_t tick, double time) {
+    size_t slot;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (freeSlots.empty()) {
+            droppedFrames.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    // the copy happens outside the lock, the slot belongs to this thread until it is queued
+    Frame &frame = frames[slot];
+    frame.tick = tick;
+    frame.time = time;
+    frame.positionX.assign(bodies.positionX.begin(), bodies.positionX.end());
+    frame.positionY.assign(bodies.positionY.begin(), bodies.positionY.end());
+    frame.id.assign(bodies.id.begin(), bodies.id.end());
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        pendingSlots.push_back(slot);
+    }
+    pendingCondition.notify_one();
+    return true;
+}
+
+void SveTrajectoryWriter::run() {
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            pendingCondition.wait(lock, [&] { return stopping || !pendingSlots.empty(); });
+            if (pendingSlots.empty()) return;  // only when stopping with nothing left to write
+            slot = pendingSlots.front();
+            pendingSlots.pop_front();
+        }
+
+        if (!failed.load(std::memory_order_relaxed)) {
+            writeFrame(frames[slot]);
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        freeSlots.push_back(slot);
+    }
+}
+
+void SveTrajectoryWriter::writeFrame(const Frame &frame) {
+    TrajectoryFrameHeader header{};
+    header.tick = frame.tick;
+    header.time = frame.time;
+    header.bodyCount = static_cast<uint32_t>(frame.positionX.size());
+
+    bool needKeyframe = framesSinceKeyframe == 0 || framesSinceKeyframe >= keyframeInterval ||
+                        keyX.size() != frame.positionX.size();
+    if (needKeyframe || !encodeDelta(frame, header)) {
+        encodeKeyframe(frame, header);
+    }
+
+    header.payloadBytes = payload.size();
+    writeBytes(&header, sizeof(header));
+    writeBytes(payload.data(), payload.size());
+}
+
+void SveTrajectoryWriter::encodeKeyframe(const Frame &frame, TrajectoryFrameHeader &header) {
+    const size_t count = frame.positionX.size();
+
+    float lo[2] = {0.f, 0.f};
+    float hi[2] = {0.f, 0.f};
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        if (!std::isfinite(frame.positionX[i]) || !std::isfinite(frame.positionY[i])) continue;
+        if (first) {
+            lo[0] = hi[0] = frame.positionX[i];
+            lo[1] = hi[1] = frame.positionY[i];
+            first = false;
+        }
+        lo[0] = std::min(lo[0], frame.positionX[i]);
+        hi[0] = std::max(hi[0], frame.positionX[i]);
+        lo[1] = std::min(lo[1], frame.positionY[i]);
+        hi[1] = std::max(hi[1], frame.positionY[i]);
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        float margin = std::max(hi[axis] - lo[axis], 1e-3f) * KEYFRAME_BOX_MARGIN;
+        keyBoxMin[axis] = lo[axis] - margin;
+        keyBoxMax[axis] = hi[axis] + margin;
+    }
+
+    const float scaleX = QUANTIZATION_LEVELS / (keyBoxMax[0] - keyBoxMin[0]);
+    const float scaleY = QUANTIZATION_LEVELS / (keyBoxMax[1] - keyBoxMin[1]);
+    keyX.resize(count);
+    keyY.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        keyX[i] = quantize(frame.positionX[i], keyBoxMin[0], scaleX);
+        keyY[i] = quantize(frame.positionY[i], keyBoxMin[1], scaleY);
+    }
+
+    payload.resize(count * (sizeof(uint32_t) + 2 * sizeof(uint16_t)));
+    uint8_t *out = payload.data();
+    std::memcpy(out, frame.id.data(), count * sizeof(uint32_t));
+    std::memcpy(out + count * sizeof(uint32_t), keyX.data(), count * sizeof(uint16_t));
+    std::memcpy(out + count * (sizeof(uint32_t) + sizeof(uint16_t)), keyY.data(), count * sizeof(uint16_t));
+
+    header.keyframe = 1;
+    std::memcpy(header.boxMin, keyBoxMin, sizeof(header.boxMin));
+    std::memcpy(header.boxMax, keyBoxMax, sizeof(header.boxMax));
+    framesSinceKeyframe = 1;
+}
+
+bool SveTrajectoryWriter::encodeDelta(const Frame &frame, TrajectoryFrameHeader &header) {
+    const size_t count = frame.positionX.size();
+    const float scaleX = QUANTIZATION_LEVELS / (keyBoxMax[0] - keyBoxMin[0]);
+    const float scaleY = QUANTIZATION_LEVELS / (keyBoxMax[1] - keyBoxMin[1]);
+
+    payload.clear();
+    for (size_t i = 0; i < count; i++) {
+        float x = frame.positionX[i];
+        float y = frame.positionY[i];
+        if (!(x >= keyBoxMin[0] && x <= keyBoxMax[0] && y >= keyBoxMin[1] && y <= keyBoxMax[1])) {
+            return false;
+        }
+        appendVarint(payload, zigzag(static_cast<int32_t>(quantize(x, keyBoxMin[0], scaleX)) - keyX[i]));
+        appendVarint(payload, zigzag(static_cast<int32_t>(quantize(y, keyBoxMin[1], scaleY)) - keyY[i]));
+    }
+
+    header.keyframe = 0;
+    std::memcpy(header.boxMin, keyBoxMin, sizeof(header.boxMin));
+    std::memcpy(header.boxMax, keyBoxMax, sizeof(header.boxMax));
+    framesSinceKeyframe++;
+    return true;
+}
+
+void SveTrajectoryWriter::writeBytes(const void *data, size_t size) {
+    if (size == 0) return;
+    if (std::fwrite(data, 1, size, file) != size) {
+        failed.store(true, std::memory_order_relaxed);
+        return;
+    }
+    bytesWritten.fetch_add(size, std::memory_order_relaxed);
+}
+
+SveTrajectoryReader::SveTrajectoryReader(const std::string &path) {
+    file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("failed to open trajectory file: " + path);
+    }
+
+    TrajectoryFileHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic)) != 0) {
+        std::fclose(file);
+        throw std::runtime_error("not a trajectory file: " + path);
+    }
+    if (header.version != SveTrajectoryWriter::VERSION ||
+        header.quantizationBits != SveTrajectoryWriter::QUANTIZATION_BITS) {
+        std::fclose(file);
+        throw std::runtime_error("unsupported trajectory version: " + path);
+    }
+}
+
+SveTrajectoryReader::~SveTrajectoryReader() { std::fclose(file); }
+
+bool SveTrajectoryReader::next(Frame &frame) {
+    TrajectoryFrameHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1) return false;
+
+    payload.resize(header.payloadBytes);
+    if (std::fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+        throw std::runtime_error("trajectory frame is truncated");
+    }
+
+    const size_t count = header.bodyCount;
+    if (header.keyframe) {
+        if (payload.size() != count * (sizeof(uint32_t) + 2 * sizeof(uint16_t))) {
+            throw std::runtime_error("trajectory keyframe has the wrong size");
+        }
+        keyId.resize(count);
+        keyX.resize(count);
+        keyY.resize(count);
+        std::memcpy(keyId.data(), payload.data(), count * sizeof(uint32_t));
+        std::memcpy(keyX.data(), payload.data() + count * sizeof(uint32_t), count * sizeof(uint16_t));
+        std::memcpy(
+            keyY.data(), payload.data() + count * (sizeof(uint32_t) + sizeof(uint16_t)), count * sizeof(uint16_t));
+        haveKeyframe = true;
+    } else if (!haveKeyframe || keyX.size() != count) {
+        throw std::runtime_error("trajectory delta frame without a matching keyframe");
+    }
+
+    const float stepX = (header.boxMax[0] - header.boxMin[0]) / QUANTIZATION_LEVELS;
+    const float stepY = (header.boxMax[1] - header.boxMin[1]) / QUANTIZATION_LEVELS;
+    frame.tick = header.tick;
+    frame.time = header.time;
+    frame.keyframe = header.keyframe != 0;
+    frame.id = keyId;
+    frame.positionX.resize(count);
+    frame.positionY.resize(count);
+
+    if (header.keyframe) {
+        for (size_t i = 0; i < count; i++) {
+            frame.positionX[i] = header.boxMin[0] + keyX[i] * stepX;
+            frame.positionY[i] = header.boxMin[1] + keyY[i] * stepY;
+        }
+        return true;
+    }
+
+    const uint8_t *in = payload.data();
+    const uint8_t *end = in + payload.size();
+    auto readVarint = [&]() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (in == end) throw std::runtime_error("trajectory delta frame is truncated");
+            uint8_t byte = *in++;
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("trajectory delta frame has a bad varint");
+    };
+    for (size_t i = 0; i < count; i++) {
+        int32_t qx = keyX[i] + unzigzag(readVarint());
+        int32_t qy = keyY[i] + unzigzag(readVarint());
+        frame.positionX[i] = header.boxMin[0] + qx * stepX;
+        frame.positionY[i] = header.boxMin[1] + qy * stepY;
+    }
+    return true;
+}
+
+}  // namespace sve
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "sve_body_store.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sve {
+
+// Trajectory files are a TrajectoryFileHeader followed by frames, each a TrajectoryFrameHeader and
+// payloadBytes of payload, so readers can skip from keyframe to keyframe without decoding.
+//
+// Positions are quantized to 16 bits per axis inside the box of the last keyframe. A keyframe
+// payload is the ids (uint32) then x and y (uint16) of every body. A delta frame stores, per body,
+// the x and y offsets from the keyframe's quantized values as zigzag varints, so slow moving bodies
+// cost a byte or two instead of eight. Values are in the byte order of the writing machine.
+struct TrajectoryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t quantizationBits;
+};
+
+struct TrajectoryFrameHeader {
+    uint32_t keyframe;  // 1 for a keyframe, 0 for a delta against the last one
+    uint32_t bodyCount;
+    uint64_t tick;
+    double time;
+    float boxMin[2];  // box the positions are quantized in, the keyframe's for delta frames
+    float boxMax[2];
+    uint64_t payloadBytes;
+};
+
+// Records body positions to a trajectory file from a background thread. record() copies the state
+// into a free slot of a fixed pool and returns, when the writer has fallen behind and every slot is
+// taken the frame is dropped rather than making the caller wait.
+class SveTrajectoryWriter {
+   public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t QUANTIZATION_BITS = 16;
+
+    // keyframeInterval is the most frames between keyframes, queueCapacity the frames that can be
+    // waiting on the writer. Throws std::runtime_error if path can't be opened
+    SveTrajectoryWriter(const std::string &path, unsigned int keyframeInterval = 30, unsigned int queueCapacity = 4);
+    // writes out every frame still queued
+    ~SveTrajectoryWriter();
+
+    SveTrajectoryWriter(const SveTrajectoryWriter &) = delete;
+    SveTrajectoryWriter &operator=(const SveTrajectoryWriter &) = delete;
+
+    // queues the positions in bodies, returns false if the frame had to be dropped
+    bool record(const SveBodyStore &bodies, uint64_t tick, double time);
+
+    uint64_t getDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+    uint64_t getBytesWritten() const { return bytesWritten.load(std::memory_order_relaxed); }
+    // set once a write fails, nothing is written after that
+    bool hasFailed() const { return failed.load(std::memory_order_relaxed); }
+
+   private:
+    struct Frame {
+        uint64_t tick;
+        double time;
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+        std::vector<uint32_t> id;
+    };
+
+    void run();
+    void writeFrame(const Frame &frame);
+    void encodeKeyframe(const Frame &frame, TrajectoryFrameHeader &header);
+    // returns false if a body left the keyframe box and a new keyframe is needed
+    bool encodeDelta(const Frame &frame, TrajectoryFrameHeader &header);
+    void writeBytes(const void *data, size_t size);
+
+    std::FILE *file;
+    const unsigned int keyframeInterval;
+
+    // slots are handed between the caller and the writer thread by index, the vectors in a slot
+    // keep their capacity so recording stops allocating after the first few frames
+    std::vector<Frame> frames;
+    std::vector<size_t> freeSlots;
+    std::deque<size_t> pendingSlots;
+    std::mutex mutex;
+    std::condition_variable pendingCondition;
+    bool stopping{false};
+
+    // writer thread state
+    std::vector<uint16_t> keyX;
+    std::vector<uint16_t> keyY;
+    float keyBoxMin[2]{};
+    float keyBoxMax[2]{};
+    unsigned int framesSinceKeyframe{0};
+    std::vector<uint8_t> payload;
+
+    std::atomic<uint64_t> droppedFrames{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<bool> failed{false};
+
+    std::thread thread;
+};
+
+// Decodes a trajectory file frame by frame, throws std::runtime_error on a malformed file
+class SveTrajectoryReader {
+   public:
+    struct Frame {
+        uint64_t tick{0};
+        double time{0.0};
+        bool keyframe{false};
+        std::vector<uint32_t> id;  // from the last keyframe
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+    };
+
+    explicit SveTrajectoryReader(const std::string &path);
+    ~SveTrajectoryReader();
+
+    SveTrajectoryReader(const SveTrajectoryReader &) = delete;
+    SveTrajectoryReader &operator=(const SveTrajectoryReader &) = delete;
+
+    // reads the next frame into frame, returns false at the end of the file
+    bool next(Frame &frame);
+
+   private:
+    std::FILE *file;
+    std::vector<uint8_t> payload;
+    std::vector<uint32_t> keyId;
+    std::vector<uint16_t> keyX;
+    std::vector<uint16_t> keyY;
+    bool haveKeyframe{false};
+};
+
+}  // namespace sve
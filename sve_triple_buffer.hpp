@@ -0,0 +1,49 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace sve {
+
+// Lock free hand off of whole values from one producer thread to one consumer thread. The producer
+// fills the write slot and publishes it, the consumer picks up the newest published slot whenever it
+// wants one. Neither side ever waits on the other, the producer just overwrites states the consumer
+// never got to.
+template <typename T>
+class SveTripleBuffer {
+   public:
+    // producer side, the slot stays owned by the producer until publish()
+    T &writeSlot() { return slots[writeIndex]; }
+
+    // hands the write slot over and takes back whichever slot was waiting in the middle
+    void publish() {
+        uint8_t previous = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // consumer side, swaps in the newest published slot, returns false if nothing new was published
+    bool acquire() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0) return false;
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    // stays valid and unchanged until the next acquire()
+    const T &readSlot() const { return slots[readIndex]; }
+
+   private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH_BIT = 4;
+
+    std::array<T, 3> slots{};
+
+    // each side's index on its own cache line so they don't bounce between the two threads
+    alignas(64) uint8_t writeIndex{0};
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t readIndex{2};
+};
+
+}  // namespace sve
@@ -0,0 +1,107 @@
+// Checks that writeSnapshot never leaves a checkpoint half written: a write that fails to open or
+// stops partway through has to leave the previous snapshot loadable and no temp file behind.
+// Exits non-zero on the first failed check.
+
+#include "sve_snapshot.hpp"
+
+// std
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// posix
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sve;
+
+static int failures = 0;
+
+static void check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static SveBodyStore createBodies(size_t count) {
+    SveBodyStore bodies{};
+    for (size_t i = 0; i < count; i++) {
+        bodies.addBody({static_cast<float>(i), -static_cast<float>(i)}, {0.5f, 0.25f}, 1.f + i);
+    }
+    return bodies;
+}
+
+static bool exists(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+// the snapshot at path has to be the one written with createBodies(count) at time
+static void checkSnapshot(const std::string &path, size_t count, double time, const char *what) {
+    SveBodyStore loaded{};
+    try {
+        double loadedTime = readSnapshot(path, loaded);
+        check(loadedTime == time && loaded.size() == count, what);
+        check(loaded.mass == createBodies(count).mass, what);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        check(false, what);
+    }
+}
+
+static bool writeFails(const std::string &path, const SveBodyStore &bodies, double time) {
+    try {
+        writeSnapshot(path, bodies, time);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    char directoryTemplate[] = "/tmp/sve_snapshot_test_XXXXXX";
+    if (mkdtemp(directoryTemplate) == nullptr) {
+        std::perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+    const std::string directory = directoryTemplate;
+    const std::string path = directory + "/state.snap";
+    const std::string tempPath = path + ".tmp";
+
+    writeSnapshot(path, createBodies(16), 1.0);
+    checkSnapshot(path, 16, 1.0, "first snapshot loads");
+
+    // the temp file can't be created at all
+    mkdir(tempPath.c_str(), 0755);
+    check(writeFails(path, createBodies(32), 2.0), "write into a blocked temp path throws");
+    checkSnapshot(path, 16, 1.0, "previous snapshot survives a failed open");
+    rmdir(tempPath.c_str());
+
+    // the file size limit cuts writev off partway, like a full disk would
+    rlimit previousLimit;
+    getrlimit(RLIMIT_FSIZE, &previousLimit);
+    rlimit limit = previousLimit;
+    limit.rlim_cur = 4096;
+    std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+    const bool shortWriteFailed = writeFails(path, createBodies(10000), 3.0);
+    setrlimit(RLIMIT_FSIZE, &previousLimit);
+    check(shortWriteFailed, "short write throws");
+    checkSnapshot(path, 16, 1.0, "previous snapshot survives a short write");
+    check(!exists(tempPath), "short write removes its temp file");
+
+    writeSnapshot(path, createBodies(10000), 4.0);
+    checkSnapshot(path, 10000, 4.0, "a later write replaces the snapshot");
+    check(!exists(tempPath), "successful write leaves no temp file");
+
+    unlink(path.c_str());
+    rmdir(directory.c_str());
+
+    if (failures > 0) return EXIT_FAILURE;
+    std::printf("snapshot tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#include "vec2_field_system.hpp"
+
+namespace sve {
+
+void Vec2FieldSystem::update(
+    const GravityPhysicsSystem& physicsSystem, const SveBodyStore& bodies, Vec2FieldSamples& field) {
+    // For each field line we caluclate the net graviation force for that point in space, the field
+    // points have unit mass so this is the same sum the simd direct solver does for bodies
+    directionX.resize(field.size());
+    directionY.resize(field.size());
+    physicsSystem.getThreadPool().parallelFor(field.size(), 256, [&](size_t begin, size_t end, unsigned int) {
+        computeAccelerations(
+            physicsSystem.simdLevel,
+            physicsSystem.strengthGravity,
+            bodies.positionX.data(),
+            bodies.positionY.data(),
+            bodies.mass.data(),
+            bodies.size(),
+            field.positionX.data() + begin,
+            field.positionY.data() + begin,
+            directionX.data() + begin,
+            directionY.data() + begin,
+            end - begin);
+    });
+
+    for (size_t s = 0; s < field.size(); s++) {
+        const glm::vec2 direction{directionX[s], directionY[s]};
+
+        // This scales the length of the field line based on the log of the length
+        // values were chosen just through trial and error based on what i liked the look
+        // of and then the field line is rotated to point in the direction of the field
+        field.scale[s] = 0.005f + 0.045f * glm::clamp(glm::log(glm::length(direction) + 1) / 3.f, 0.f, 1.f);
+        field.rotation[s] = atan2(direction.y, direction.x);
+    }
+}
+
+}  // namespace sve
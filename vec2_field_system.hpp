@@ -0,0 +1,38 @@
+#pragma once
+
+#include "gravity_physics_system.hpp"
+#include "sve_body_store.hpp"
+
+// std
+#include <vector>
+
+namespace sve {
+
+// Points the vector field is sampled at, stored as arrays like SveBodyStore. update() fills in the
+// length (scale) and direction (rotation) of the glyph drawn at each point.
+struct Vec2FieldSamples {
+    size_t size() const { return positionX.size(); }
+
+    void addSample(glm::vec2 position) {
+        positionX.push_back(position.x);
+        positionY.push_back(position.y);
+        scale.push_back(0.005f);
+        rotation.push_back(0.f);
+    }
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> scale;
+    std::vector<float> rotation;
+};
+
+class Vec2FieldSystem {
+   public:
+    void update(const GravityPhysicsSystem &physicsSystem, const SveBodyStore &bodies, Vec2FieldSamples &field);
+
+   private:
+    std::vector<float> directionX;
+    std::vector<float> directionY;
+};
+
+}  // namespace sve